@@ -0,0 +1,173 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_ADAPTIVE_SORT_HPP
+#define CAV_INCLUDE_ADAPTIVE_SORT_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sort.hpp"
+#include "sort_utils.hpp"
+#include "utils.hpp"
+
+namespace cav {
+
+namespace {
+    constexpr uint8_t log2_floor(size_t n) {
+        return n <= 1 ? 0 : 1 + log2_floor(n / 2);
+    }
+}  // namespace
+
+/// @brief Sorter that learns at runtime the fastest algorithm for each shape of input, i.e., each
+/// (value size, key size, log2 N) bucket. Most calls just run the best algorithm found so far and
+/// are not timed; with probability 2^-explore_log2 a call is timed while running the next candidate
+/// (round-robin), so the per-shape estimates follow workload drifts (epsilon-greedy policy).
+template <typename SzT  = uint32_t,
+          typename AlcT = std::allocator<char>,
+          typename StT  = NoSortStats>
+struct AdaptiveSorter : Sorter<SzT, AlcT, StT> {
+    using base_type  = Sorter<SzT, AlcT, StT>;
+    using size_type  = SzT;
+    using alloc_type = AlcT;
+
+    // Candidates: all the SortAlgo up to radix_str, which only sorts string keys
+    static constexpr uint8_t n_algos        = static_cast<uint8_t>(SortAlgo::radix_str);
+    static constexpr uint8_t n_val_sizes    = 8;   // 1, 2, 4, ..., >=128 bytes
+    static constexpr uint8_t n_key_sizes    = 5;   // 1, 2, 4, 8, >=16 bytes
+    static constexpr uint8_t n_log_sizes    = 25;  // 2^0, 2^1, ..., >=2^24 elements
+    static constexpr size_t  n_shapes       = n_val_sizes * n_key_sizes * n_log_sizes;
+    static constexpr size_t  max_insertion  = 256;
+    static constexpr float   ewma_weight    = 0.25F;
+    static constexpr uint8_t default_period = 4;
+
+    struct AlgoStats {
+        float    ns_per_elem = 0.0F;  // exponentially weighted moving average
+        uint32_t samples     = 0;
+    };
+
+    struct ShapeStats {
+        AlgoStats algos[n_algos] = {};
+        uint32_t  calls          = 0;
+        SortAlgo  best           = SortAlgo::radix_lsd;
+        SortAlgo  probe          = SortAlgo::net_sort;
+    };
+
+    explicit AdaptiveSorter(uint8_t explore_log2_ = default_period)
+        : explore_log2(explore_log2_) {
+        assert(0 < explore_log2_ && explore_log2_ < 32);
+    }
+
+    AdaptiveSorter(uint8_t explore_log2_, alloc_type const& alc)
+        : base_type{typename base_type::SorterData(alc)}
+        , explore_log2(explore_log2_) {
+        assert(0 < explore_log2_ && explore_log2_ < 32);
+    }
+
+    template <typename C, typename K = IdentityFtor>
+    void sort(C& container, K key = {}) {
+        size_t n = cav::size(container);
+        if (n < 2)
+            return;
+
+        constexpr size_t val_size = sizeof(sort::value_t<C>);
+        constexpr size_t key_size = sizeof(sort::key_t<C, K>);
+
+        ShapeStats& shape  = shapes[shape_index(val_size, key_size, n)];
+        bool        warmup = shape.calls < 2U * n_algos;  // try each candidate twice
+        ++shape.calls;
+        if (!warmup && (_next_rand() >> (32U - explore_log2)) != 0) {
+            _run(shape.best, container, key);
+            assert_sorted(container, sort::make_cmp_key<C>(key));
+            return;
+        }
+
+        SortAlgo algo = shape.probe;
+        if (n > max_insertion && algo == SortAlgo::insertion)
+            algo = _next_candidate(algo, n);
+        shape.probe = _next_candidate(algo, n);
+
+        auto start = std::chrono::steady_clock::now();
+        _run(algo, container, key);
+        auto  stop    = std::chrono::steady_clock::now();
+        float elapsed = std::chrono::duration<float, std::nano>(stop - start).count();
+        _update(shape, algo, elapsed / static_cast<float>(n));
+        assert_sorted(container, sort::make_cmp_key<C>(key));
+    }
+
+    /// @brief Statistics collected for the given shape (value size, key size, container size).
+    ShapeStats const& shape_stats(size_t val_size, size_t key_size, size_t n) const {
+        return shapes[shape_index(val_size, key_size, n)];
+    }
+
+    void reset_stats() {
+        std::fill(shapes.begin(), shapes.end(), ShapeStats{});
+    }
+
+    static size_t shape_index(size_t val_size, size_t key_size, size_t n) {
+        size_t vs = min(log2_floor(val_size), n_val_sizes - 1U);
+        size_t ks = min(log2_floor(key_size), n_key_sizes - 1U);
+        size_t ls = min(log2_floor(n), n_log_sizes - 1U);
+        return (vs * n_key_sizes + ks) * n_log_sizes + ls;
+    }
+
+private:
+    template <typename C, typename K>
+    void _run(SortAlgo algo, C& container, K key) {
+        switch (algo) {
+        case SortAlgo::net_sort:
+            return base_type::net_sort(container, key);
+        case SortAlgo::radix_lsd:
+            return base_type::radix_sort_lsd(container, key);
+        case SortAlgo::radix_msd:
+            return base_type::radix_sort_msd(container, key);
+        case SortAlgo::insertion:
+            return base_type::_insertion_sort(container, key);
+        case SortAlgo::key_index:
+            return base_type::key_index_sort(container, key);
+        default:
+            return base_type::std_sort(container, key);
+        }
+    }
+
+    /// @brief Round-robin over the candidates, insertion sort is skipped for large containers.
+    static SortAlgo _next_candidate(SortAlgo algo, size_t n) {
+        auto next = static_cast<uint8_t>((static_cast<uint8_t>(algo) + 1U) % n_algos);
+        if (n > max_insertion && next == static_cast<uint8_t>(SortAlgo::insertion))
+            ++next;
+        return static_cast<SortAlgo>(next);
+    }
+
+    static void _update(ShapeStats& shape, SortAlgo algo, float ns_per_elem) {
+        AlgoStats& as = shape.algos[static_cast<uint8_t>(algo)];
+        as.ns_per_elem += as.samples == 0 ? ns_per_elem
+                                          : (ns_per_elem - as.ns_per_elem) * ewma_weight;
+        ++as.samples;
+
+        for (uint8_t a = 0; a < n_algos; ++a) {
+            AlgoStats const& other = shape.algos[a];
+            AlgoStats const& best  = shape.algos[static_cast<uint8_t>(shape.best)];
+            if (other.samples > 0 && (best.samples == 0 || other.ns_per_elem < best.ns_per_elem))
+                shape.best = static_cast<SortAlgo>(a);
+        }
+    }
+
+    uint32_t _next_rand() {  // xorshift32
+        rng_state ^= rng_state << 13U;
+        rng_state ^= rng_state >> 17U;
+        rng_state ^= rng_state << 5U;
+        return rng_state;
+    }
+
+    uint8_t                 explore_log2;
+    uint32_t                rng_state = 0x9E3779B9U;
+    std::vector<ShapeStats> shapes    = std::vector<ShapeStats>(n_shapes);
+};
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_ADAPTIVE_SORT_HPP */
@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_COUNTING_ALLOCATOR_HPP
+#define CAV_INCLUDE_COUNTING_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+namespace cav {
+
+/// @brief Minor page faults of the process so far (0 where getrusage is not available).
+inline long minor_page_faults() noexcept {
+#ifdef __unix__
+    auto usage = rusage();
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+#else
+    return 0;
+#endif
+}
+
+/// @brief Memory usage recorded by one or more CountingAllocator. Not thread-safe: give each
+/// thread its own counters.
+struct AllocCounters {
+    uint64_t allocs      = 0;
+    uint64_t deallocs    = 0;
+    uint64_t alloc_bytes = 0;  // cumulative
+    uint64_t live_bytes  = 0;
+    uint64_t peak_bytes  = 0;  // max of live_bytes since the last reset
+    long     faults_base = minor_page_faults();
+
+    void add_alloc(size_t bytes) noexcept {
+        ++allocs;
+        alloc_bytes += bytes;
+        live_bytes += bytes;
+        peak_bytes = live_bytes > peak_bytes ? live_bytes : peak_bytes;
+    }
+
+    void add_dealloc(size_t bytes) noexcept {
+        ++deallocs;
+        live_bytes -= bytes;
+    }
+
+    /// @brief Minor page faults of the whole process since the last reset.
+    long minor_faults() const noexcept {
+        return minor_page_faults() - faults_base;
+    }
+
+    /// @brief Restarts the counts, the memory still allocated stays live (and is the new peak).
+    void reset() noexcept {
+        allocs      = 0;
+        deallocs    = 0;
+        alloc_bytes = 0;
+        peak_bytes  = live_bytes;
+        faults_base = minor_page_faults();
+    }
+};
+
+/// @brief Process-wide counters used by default constructed CountingAllocator.
+inline AllocCounters& default_alloc_counters() noexcept {
+    static AllocCounters counters;
+    return counters;
+}
+
+/// @brief Allocator adaptor recording allocations, deallocations and peak live bytes of BaseT in
+/// an AllocCounters. Copies and rebound copies share the same counters, so it can be given to
+/// Sorter (or to any standard container) and inspected from outside:
+///
+///     auto sorter = cav::Sorter<uint32_t, cav::CountingAllocator<char>>();
+///     sorter.sort(vec);
+///     fmt::print("scratch peak: {} bytes\n", sorter.get_allocator().counters().peak_bytes);
+template <typename T, typename BaseT = std::allocator<T>>
+class CountingAllocator : private BaseT {
+    using base_traits = std::allocator_traits<BaseT>;
+
+public:
+    using value_type = T;
+    using base_type  = BaseT;
+
+    template <typename U>
+    struct rebind {
+        using other = CountingAllocator<U, typename base_traits::template rebind_alloc<U>>;
+    };
+
+    CountingAllocator() noexcept
+        : cnts(&default_alloc_counters()) {
+    }
+
+    explicit CountingAllocator(AllocCounters& counters, BaseT const& base = BaseT()) noexcept
+        : BaseT(base)
+        , cnts(&counters) {
+    }
+
+    template <typename U, typename BaseU>
+    CountingAllocator(CountingAllocator<U, BaseU> const& other) noexcept
+        : BaseT(other.base())
+        , cnts(&other.counters()) {
+    }
+
+    T* allocate(size_t n) {
+        T* ptr = base_traits::allocate(*this, n);
+        cnts->add_alloc(n * sizeof(T));
+        return ptr;
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (ptr == nullptr)
+            return;
+        cnts->add_dealloc(n * sizeof(T));
+        base_traits::deallocate(*this, ptr, n);
+    }
+
+    AllocCounters& counters() const noexcept {
+        return *cnts;
+    }
+
+    BaseT const& base() const noexcept {
+        return *this;
+    }
+
+    template <typename U, typename BaseU>
+    bool operator==(CountingAllocator<U, BaseU> const& other) const noexcept {
+        return cnts == &other.counters() && base() == other.base();
+    }
+
+    template <typename U, typename BaseU>
+    bool operator!=(CountingAllocator<U, BaseU> const& other) const noexcept {
+        return !(*this == other);
+    }
+
+private:
+    AllocCounters* cnts;
+};
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_COUNTING_ALLOCATOR_HPP */
@@ -0,0 +1,197 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_HUGE_PAGE_ALLOCATOR_HPP
+#define CAV_INCLUDE_HUGE_PAGE_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "numa.hpp"
+#include "utils.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace cav {
+
+/// @brief Where the allocations of HugePageAllocator ended up, process-wide.
+struct HugePageCounters {
+    std::atomic<uint64_t> hugetlb{0};      // explicit 2 MiB pages (MAP_HUGETLB)
+    std::atomic<uint64_t> thp{0};          // 2 MiB aligned mappings advised for transparent THP
+    std::atomic<uint64_t> aligned{0};      // small (or non-Linux) requests, 64 bytes aligned heap
+    std::atomic<uint64_t> numa_pinned{0};  // prefault threads pinned to the node of the caller
+};
+
+inline HugePageCounters& huge_page_counters() noexcept {
+    static HugePageCounters counters;
+    return counters;
+}
+
+/// @brief Allocator for large scratch buffers, like the one Sorter keeps between calls:
+///
+///     auto sorter = cav::Sorter<uint32_t, cav::HugePageAllocator<char>>();
+///
+/// Requests of at least huge_page_size bytes are rounded up to 2 MiB and mapped with explicit
+/// huge pages (MAP_HUGETLB) when the system has them reserved, otherwise with a 2 MiB aligned
+/// mapping advised for transparent huge pages (MADV_HUGEPAGE), so the radix scatter passes do not
+/// miss the TLB on every page. The pages are faulted in right away, split among
+/// `prefault_threads` threads for large buffers (0: one per hardware thread), so that the first
+/// sort does not pay for them. On NUMA hosts the prefault threads are pinned to the node of the
+/// calling thread, so that first-touch places the whole buffer where it is going to be used (a
+/// single node, per /sys/devices/system/node, changes nothing). Smaller requests, and all of them
+/// outside Linux, come from the heap aligned to a cache line. Since Sorter keeps its buffer between
+/// calls, the mapping is then reused by all the following ones (up to its high-water mark, if one
+/// is set).
+template <typename T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t huge_page_size          = size_t{2} << 20U;
+    static constexpr size_t cache_line_size         = 64;
+    static constexpr size_t parallel_prefault_bytes = size_t{64} << 20U;  // per thread at least
+
+    template <typename U>
+    struct rebind {
+        using other = HugePageAllocator<U>;
+    };
+
+    HugePageAllocator() noexcept = default;
+
+    explicit HugePageAllocator(unsigned prefault_threads) noexcept
+        : n_threads(prefault_threads) {
+    }
+
+    template <typename U>
+    HugePageAllocator(HugePageAllocator<U> const& other) noexcept
+        : n_threads(other.prefault_threads()) {
+    }
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+#ifdef __linux__
+        if (bytes >= huge_page_size)
+            return static_cast<T*>(_map_huge(_round_up(bytes, huge_page_size)));
+#endif
+        return static_cast<T*>(_alloc_aligned(bytes));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (ptr == nullptr)
+            return;
+        size_t bytes = n * sizeof(T);
+#ifdef __linux__
+        if (bytes >= huge_page_size) {
+            munmap(ptr, _round_up(bytes, huge_page_size));
+            return;
+        }
+#endif
+        std::free(static_cast<void**>(static_cast<void*>(ptr))[-1]);
+    }
+
+    unsigned prefault_threads() const noexcept {
+        return n_threads;
+    }
+
+    template <typename U>
+    bool operator==(HugePageAllocator<U> const& /*other*/) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(HugePageAllocator<U> const& /*other*/) const noexcept {
+        return false;
+    }
+
+private:
+    static size_t _round_up(size_t bytes, size_t align) noexcept {
+        return (bytes + align - 1) / align * align;
+    }
+
+    /// @brief Heap block aligned to a cache line, the malloc pointer is stored right before it.
+    static void* _alloc_aligned(size_t bytes) {
+        void* raw = std::malloc(bytes + cache_line_size + sizeof(void*));
+        if (raw == nullptr)
+            throw std::bad_alloc();
+        auto  addr = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+        auto* ptr  = reinterpret_cast<void**>(_round_up(addr, cache_line_size));
+        ptr[-1]    = raw;
+        huge_page_counters().aligned.fetch_add(1, std::memory_order_relaxed);
+        return ptr;
+    }
+
+#ifdef __linux__
+    void* _map_huge(size_t bytes) const {
+        constexpr int prot  = PROT_READ | PROT_WRITE;
+        constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        size_t        page  = huge_page_size;
+
+        void* ptr = mmap(nullptr, bytes, prot, flags | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            huge_page_counters().hugetlb.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // No reserved huge pages: over-map to cut a 2 MiB aligned range, which the kernel
+            // can back with transparent huge pages
+            auto* raw = static_cast<char*>(mmap(nullptr, bytes + page, prot, flags, -1, 0));
+            if (raw == MAP_FAILED)
+                throw std::bad_alloc();
+            auto* beg  = reinterpret_cast<char*>(_round_up(reinterpret_cast<uintptr_t>(raw), page));
+            auto  head = static_cast<size_t>(beg - raw);
+            if (head > 0)
+                munmap(raw, head);
+            munmap(beg + bytes, page - head);
+            madvise(beg, bytes, MADV_HUGEPAGE);
+            ptr  = beg;
+            page = 4096;  // worst case, touch every base page
+            huge_page_counters().thp.fetch_add(1, std::memory_order_relaxed);
+        }
+        _prefault(static_cast<char*>(ptr), bytes, page);
+        return ptr;
+    }
+
+    void _prefault(char* ptr, size_t bytes, size_t page) const {
+        auto touch = [=](size_t beg, size_t end) {
+            for (size_t i = beg; i < end; i += page)
+                static_cast<char volatile*>(ptr)[i] = 0;
+        };
+        // Threads of other nodes would first-touch their chunks there: keep them on ours
+        NumaTopology const& topo    = numa_topology();
+        NumaNode const*     node    = topo.single_node() ? nullptr : topo.current_node();
+        auto                on_node = [=](size_t beg, size_t end) {
+            if (node != nullptr && pin_current_thread(node->cpus))
+                huge_page_counters().numa_pinned.fetch_add(1, std::memory_order_relaxed);
+            touch(beg, end);
+        };
+
+        size_t max_threads = n_threads > 0 ? n_threads : std::thread::hardware_concurrency();
+        if (node != nullptr)
+            max_threads = min(max_threads, node->cpus.size());
+        size_t threads = std::min(max_threads, bytes / parallel_prefault_bytes);
+        if (threads <= 1)
+            return touch(0, bytes);
+
+        size_t chunk   = _round_up(bytes / threads, page);
+        auto   workers = std::vector<std::thread>();
+        for (size_t t = 1; t < threads; ++t)
+            workers.emplace_back(on_node, min(t * chunk, bytes), min((t + 1) * chunk, bytes));
+        touch(0, min(chunk, bytes));
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+#endif
+
+    unsigned n_threads = 0;
+};
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_HUGE_PAGE_ALLOCATOR_HPP */
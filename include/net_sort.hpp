@@ -9,8 +9,12 @@
 #endif
 #include <cassert>
 
+#ifndef CAV_MAX_NET_SIZE  // largest network used, measure it with the net_bench target
 #define CAV_MAX_NET_SIZE 32U
+#endif
 #include "Span.hpp"
+#include "sort_stats.hpp"
+#include "sort_trace.hpp"
 #include "sort_utils.hpp"
 #include "sorting_networks.hpp"
 #include "utils.hpp"
@@ -55,6 +59,7 @@ namespace {
     /// always grow until they can be merged).
     template <typename SzT, typename C1, typename C2, typename K>
     SzT chunks_merge(C1& cont1, C2& cont2, SzT curr_size, SzT old_residual, K key) {
+        CAV_TRACE_SCOPE("net_merge", curr_size);
         SzT csize = cav::size(cont1);
         SzT i     = 0;
         for (; i < csize - curr_size; i += (2 * curr_size)) {
@@ -77,16 +82,24 @@ namespace {
     }
 }  // namespace
 
-template <typename SzT, typename C1, typename C2, typename K = IdentityFtor>
-static void net_sort(C1& container, C2& buff, K key = {}) {
+template <typename SzT,
+          typename C1,
+          typename C2,
+          typename K  = IdentityFtor,
+          typename St = NoSortStats>
+static void net_sort(C1& container, C2& buff, K key_ftor = {}, St&& stats = {}) {
     assert(cav::size(container) <= cav::size(buff));
+    auto key       = sort::make_cmp_key<C1>(key_ftor);
     auto buff_span = make_span(std::begin(buff), cav::size(container));
     SzT  csize     = cav::size(container);
 
-    for (SzT i = 0; i < csize; i += CAV_MAX_NET_SIZE) {
-        SzT  residual = min(CAV_MAX_NET_SIZE, csize - i);
-        auto chunk    = make_span(std::begin(container) + i, residual);
-        net_dispatch(chunk, key);
+    {
+        CAV_TRACE_SCOPE("net_chunks", csize);
+        for (SzT i = 0; i < csize; i += CAV_MAX_NET_SIZE) {
+            SzT  residual = min(CAV_MAX_NET_SIZE, csize - i);
+            auto chunk    = make_span(std::begin(container) + i, residual);
+            net_dispatch(chunk, key);
+        }
     }
 
     SzT curr_size    = CAV_MAX_NET_SIZE;
@@ -95,13 +108,17 @@ static void net_sort(C1& container, C2& buff, K key = {}) {
 
         old_residual = chunks_merge<SzT>(container, buff_span, curr_size, old_residual, key);
         curr_size *= 2;
+        stats.add_moves(csize, sizeof(sort::value_t<C1>));
         if (curr_size >= csize) {
+            CAV_TRACE_SCOPE("move_uninit_span", csize);
             move_uninit_span(container, buff_span);
+            stats.add_moves(csize, sizeof(sort::value_t<C1>));
             return;
         }
 
         old_residual = chunks_merge<SzT>(buff_span, container, curr_size, old_residual, key);
         curr_size *= 2;
+        stats.add_moves(csize, sizeof(sort::value_t<C1>));
     }
 }
 }  // namespace cav
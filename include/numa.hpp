@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_NUMA_HPP
+#define CAV_INCLUDE_NUMA_HPP
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace cav {
+
+/// @brief Parses a Linux cpu/node list like "0-3,8,10-11" into `out`, false if malformed.
+inline bool parse_id_list(std::string const& list, std::vector<unsigned>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < list.size() && list[pos] != '\n') {
+        if (!std::isdigit(static_cast<unsigned char>(list[pos])))
+            return false;
+        char*         end = nullptr;
+        unsigned long beg = std::strtoul(list.c_str() + pos, &end, 10);
+        unsigned long lst = beg;
+        pos               = static_cast<size_t>(end - list.c_str());
+        if (pos < list.size() && list[pos] == '-') {
+            char const* from = list.c_str() + pos + 1;
+            if (!std::isdigit(static_cast<unsigned char>(*from)))
+                return false;
+            lst = std::strtoul(from, &end, 10);
+            if (lst < beg)
+                return false;
+            pos = static_cast<size_t>(end - list.c_str());
+        }
+        for (unsigned long id = beg; id <= lst; ++id)
+            out.push_back(static_cast<unsigned>(id));
+        if (pos < list.size() && list[pos] == ',')
+            ++pos;
+    }
+    return true;
+}
+
+struct NumaNode {
+    unsigned              id = 0;
+    std::vector<unsigned> cpus;
+};
+
+/// @brief NUMA nodes and their CPUs, as listed in /sys/devices/system/node. Without that
+/// directory (other systems, containers hiding it) there are no nodes and single_node() is true,
+/// so the callers keep their non-NUMA behavior.
+struct NumaTopology {
+    std::vector<NumaNode> nodes;
+
+    static NumaTopology load(std::string const& root = "/sys/devices/system/node") {
+        auto topo   = NumaTopology();
+        auto online = std::vector<unsigned>();
+        if (!parse_id_list(_read_line(root + "/online"), online))
+            return topo;
+        for (unsigned id : online) {
+            auto node = NumaNode();
+            node.id   = id;
+            if (parse_id_list(_read_line(root + "/node" + std::to_string(id) + "/cpulist"),
+                              node.cpus) &&
+                !node.cpus.empty())
+                topo.nodes.push_back(node);
+        }
+        return topo;
+    }
+
+    bool single_node() const noexcept {
+        return nodes.size() <= 1;
+    }
+
+    /// @brief Node owning `cpu`, nullptr if unknown.
+    NumaNode const* node_of_cpu(unsigned cpu) const noexcept {
+        for (NumaNode const& node : nodes)
+            for (unsigned c : node.cpus)
+                if (c == cpu)
+                    return &node;
+        return nullptr;
+    }
+
+    /// @brief Node of the CPU the calling thread is running on, nullptr if unknown.
+    NumaNode const* current_node() const noexcept {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if (cpu >= 0)
+            return node_of_cpu(static_cast<unsigned>(cpu));
+#endif
+        return nullptr;
+    }
+
+private:
+    static std::string _read_line(std::string const& path) {
+        std::ifstream in(path);
+        auto          line = std::string();
+        std::getline(in, line);
+        return line;
+    }
+};
+
+/// @brief Topology of the host, read once.
+inline NumaTopology const& numa_topology() {
+    static NumaTopology const topo = NumaTopology::load();
+    return topo;
+}
+
+/// @brief Restricts the calling thread to `cpus`, so that the pages it touches first are placed on
+/// their node. Returns false if unsupported or refused.
+inline bool pin_current_thread(std::vector<unsigned> const& cpus) noexcept {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned cpu : cpus)
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    static_cast<void>(cpus);
+    return false;
+#endif
+}
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_NUMA_HPP */
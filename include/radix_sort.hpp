@@ -6,9 +6,12 @@
 
 #include <cassert>
 #include <cstdint>
+#include <tuple>
 #include <type_traits>
 
 #include "Span.hpp"
+#include "sort_stats.hpp"
+#include "sort_trace.hpp"
 #include "sort_utils.hpp"
 #include "sorting_networks.hpp"
 #include "utils.hpp"
@@ -19,11 +22,22 @@ namespace cav {
 //////////////////////////////// RADIX SORT ////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////
 namespace {
+    /// @brief LSD pass on the byte `lo + b`, returns the next pass to run (skipping constant
+    /// bytes).
     template <typename SzT, typename C1, typename C2, typename K, size_t Nb>
-    SzT byte_sort_lsd(C1& cont1, C2& cont2, K key, SzT b, SzT (&counters)[256], SzT (&nnz)[Nb]) {
+    size_t byte_sort_lsd(C1&    cont1,
+                         C2&    cont2,
+                         K      key,
+                         size_t lo,
+                         size_t b,
+                         SzT (&counters)[256],
+                         SzT (&nnz)[Nb]) {
+        CAV_TRACE_SCOPE("lsd_scatter", lo + b);
 
+        size_t i = 0;
         for (auto& elem : cont1) {
-            auto k = nth_byte(to_uint(key(elem)), b);
+            sort::prefetch_ahead(cont1, key, i++);
+            auto k = nth_byte(to_uint(key(elem)), lo + b);
             assert(counters[k] < cav::size(cont2));
             move_uninit(cont2[counters[k]], elem);
             ++counters[k];
@@ -40,89 +54,306 @@ namespace {
         SzT end;
     };
 
-    template <typename SzT, typename C1, typename C2, typename K = IdentityFtor>
-    BegEnd<SzT> byte_sort_msd(C1& cont, C2& buff, K key, uint8_t b, SzT (&counters)[256]) {
-        if (cav::size(cont) < sizeof(sort::key_t<C1, K>) * 12) {
-            insertion_sort(cont, key);
-            return {0, 0};
+    /// @brief MSD distribution pass: counts the digits of `cont`, turns `counters` into bucket
+    /// ends and moves each element into its bucket in `buff`. Returns the non-empty buckets range.
+    /// Digit functors with a prefetch() member get it called ahead of both passes.
+    template <typename SzT, typename C1, typename C2, typename D, size_t Nd>
+    BegEnd<SzT> distribute_msd(C1& cont, C2& buff, D digit, SzT (&counters)[Nd]) {
+        SzT    beg = 0, end = 0;
+        size_t i = 0;
+        for (auto& elem : cont) {
+            sort::prefetch_ahead(cont, digit, i++);
+            ++counters[digit(elem)];
         }
 
-        SzT beg = 0, end = 0;
-        for (auto& elem : cont)
-            ++counters[nth_byte(to_uint(key(elem)), b)];
-
         for (SzT accum = 0; accum < cav::size(cont); ++end) {
             SzT old_count = counters[end];
             counters[end] = accum;
             beg           = accum == 0 ? end : beg;
             accum += old_count;
-            assert(end <= 256 && beg <= end);
+            assert(end <= Nd && beg <= end);
         }
 
+        i = 0;
         for (auto& elem : cont) {
-            uint8_t k = nth_byte(to_uint(key(elem)), b);
-            move_uninit(buff[counters[k]], elem);
-            ++counters[k];
+            sort::prefetch_ahead(cont, digit, i++);
+            auto d = digit(elem);
+            move_uninit(buff[counters[d]], elem);
+            ++counters[d];
         }
         assert(counters[beg] > 0 && counters[end - 1] == cav::size(cont));
-        assert_sorted(buff,
-                      [&](sort::value_t<C1> const& c) { return nth_byte(to_uint(key(c)), b); });
         return {beg, end};
     }
+
+    /// @brief Digit of the byte `b` of the keys, forwarding prefetch() to the key if it has one.
+    template <typename K>
+    struct ByteDigit {
+        K&     key;
+        size_t b;
+
+        template <typename T>
+        uint8_t operator()(T const& v) {
+            return nth_byte(to_uint(key(v)), b);
+        }
+
+        template <typename T, typename K2 = K>
+        auto prefetch(T const& v) -> decltype(std::declval<K2&>().prefetch(v)) {
+            key.prefetch(v);
+        }
+    };
+
+    template <typename SzT, typename C1, typename C2, typename K, typename St>
+    BegEnd<SzT> byte_sort_msd(C1&    cont,
+                              C2&    buff,
+                              K      key,
+                              size_t b,
+                              SzT (&counters)[256],
+                              St&    stats) {
+        if (cav::size(cont) < sizeof(sort::key_t<C1, K>) * 12) {
+            sort::prefetch_all(cont, key);
+            insertion_sort(cont, key);
+            stats.add_fallback();
+            return {0, 0};
+        }
+
+        auto byte_digit = ByteDigit<K>{key, b};
+        auto srng       = distribute_msd(cont, buff, byte_digit, counters);
+        stats.add_passes(1, 0);
+        stats.add_moves(cav::size(cont), sizeof(sort::value_t<C1>));
+        assert_sorted(buff, byte_digit);
+        return srng;
+    }
+
+    /// @brief Returns the most significant byte, starting from `b`, that is not shared by all the
+    /// keys in `cont`. Constant prefixes (common in IDs) are skipped without any scatter. The scan
+    /// stops at the first mismatch, so it costs almost nothing when the byte is not constant.
+    template <typename C, typename K>
+    size_t skip_common_bytes(C& cont, K key, size_t b) {
+        auto first = to_uint(key(*std::begin(cont)));
+        for (; b > sort::lo_byte<C, K>(); --b) {
+            uint8_t first_b = nth_byte(first, b);
+            if (any(cont, [&](sort::value_t<C> const& c) {
+                    return nth_byte(to_uint(key(c)), b) != first_b;
+                }))
+                return b;
+        }
+        return b;
+    }
+
+    /// @brief Moves of the I-th to last columns of a tuple of spans (recursing over I).
+    template <size_t I, size_t N>
+    struct ColumnsMover {
+        template <typename S, typename D>
+        static void move_elem(S& srcs, D& dsts, size_t from, size_t to) {
+            move_uninit(std::get<I>(dsts)[to], std::get<I>(srcs)[from]);
+            ColumnsMover<I + 1, N>::move_elem(srcs, dsts, from, to);
+        }
+
+        template <typename S, typename D>
+        static void move_all(S& srcs, D& dsts) {
+            move_uninit_span(std::get<I>(dsts), std::get<I>(srcs));
+            ColumnsMover<I + 1, N>::move_all(srcs, dsts);
+        }
+
+        template <typename S>
+        static constexpr size_t row_size() {
+            return sizeof(sort::value_t<typename std::tuple_element<I, S>::type>) +
+                   ColumnsMover<I + 1, N>::template row_size<S>();
+        }
+    };
+
+    template <size_t N>
+    struct ColumnsMover<N, N> {
+        template <typename S, typename D>
+        static void move_elem(S& /*srcs*/, D& /*dsts*/, size_t /*from*/, size_t /*to*/) {
+        }
+
+        template <typename S, typename D>
+        static void move_all(S& /*srcs*/, D& /*dsts*/) {
+        }
+
+        template <typename S>
+        static constexpr size_t row_size() {
+            return 0;
+        }
+    };
+
+    /// @brief LSD pass of radix_sort_lsd_columns on the byte `lo + b` of the keys (the first
+    /// column): every column is scattered with the same destinations. Returns the next pass to run.
+    template <typename SzT, typename S, typename D, size_t Nb>
+    size_t columns_sort_lsd(S&     srcs,
+                            D&     dsts,
+                            size_t lo,
+                            size_t b,
+                            SzT (&counters)[256],
+                            SzT (&nnz)[Nb]) {
+        CAV_TRACE_SCOPE("lsd_scatter", lo + b);
+        constexpr size_t n_cols = std::tuple_size<S>::value;
+
+        auto&  keys = std::get<0>(srcs);
+        size_t n    = cav::size(keys);
+        for (size_t i = 0; i < n; ++i) {
+            auto k = nth_byte(to_uint(keys[i]), lo + b);
+            assert(counters[k] < n);
+            ColumnsMover<0, n_cols>::move_elem(srcs, dsts, i, counters[k]);
+            ++counters[k];
+        }
+
+        for (;;)
+            if (++b == Nb || nnz[b] > 1)
+                return b;
+    }
 }  // namespace
 
-template <typename SzT, typename C1, typename C2, typename K = IdentityFtor>
-static void radix_sort_lsd(C1& cont, C2& buff, K key = {}) {
-    static_assert(std::is_unsigned<sort::ukey_t<C1, K>>::value, "Key type must be unsigned");
-    constexpr uint8_t n_bytes = sizeof(sort::key_t<C1, K>);
+/// @brief LSD radix sort of a structure of arrays: `cols` holds spans of the key column (sorted by
+/// its values) followed by the payload columns, of the same size, and `buffs` as many spans of
+/// uninitialized memory of the same types and size. Each pass scatters all the columns with the
+/// digits of the keys, so no array of records nor permutation is materialized. Stable.
+template <typename SzT, typename... Cs, typename... Bs, typename St = NoSortStats>
+static void radix_sort_lsd_columns(std::tuple<Cs...> cols,
+                                   std::tuple<Bs...> buffs,
+                                   St&&              stats = {}) {
+    static_assert(sizeof...(Cs) == sizeof...(Bs), "One buffer per column");
+    using keys_t              = typename std::tuple_element<0, std::tuple<Cs...>>::type;
+    using cols_t              = std::tuple<Cs...>;
+    constexpr size_t n_cols   = sizeof...(Cs);
+    constexpr size_t lo_byte  = sort::lo_byte<keys_t, IdentityFtor>();
+    constexpr size_t n_passes = sort::n_bytes<keys_t, IdentityFtor>() - lo_byte;
+    static_assert(is_radix_ukey<sort::ukey_t<keys_t, IdentityFtor>>::value,
+                  "Key type must be unsigned");
+
+    auto& keys = std::get<0>(cols);
+    assert(cav::size(keys) == cav::size(std::get<0>(buffs)));
+
+    SzT counters[n_passes][256] = {};
+    {
+        CAV_TRACE_SCOPE("lsd_histogram", cav::size(keys));
+        for (auto const& key : keys) {
+            auto ukey = to_uint(key);
+            for (size_t b = 0; b < n_passes; ++b)
+                ++counters[b][nth_byte(ukey, lo_byte + b)];
+        }
+    }
+
+    SzT accum[n_passes] = {};
+    SzT nnz[n_passes]   = {};  // to skip bytes
+    for (SzT i = 0; i < 256; ++i)
+        for (size_t b = 0; b < n_passes; ++b) {
+            SzT old_count  = counters[b][i];
+            counters[b][i] = accum[b];
+            accum[b] += old_count;
+            nnz[b] += old_count > 0;
+        }
+
+    SzT n_run = 0;
+    for (size_t b = 0; b < n_passes; ++b)
+        n_run += nnz[b] > 1;
+    stats.add_passes(n_run, n_passes - n_run);
+    stats.add_moves(cav::size(keys) * (n_run + n_run % 2U),
+                    ColumnsMover<0, n_cols>::template row_size<cols_t>());
+
+    size_t b = 0;
+    while (b < n_passes && nnz[b] <= 1)  // constant bytes need no pass
+        ++b;
+    while (b < n_passes) {
+        b = columns_sort_lsd(cols, buffs, lo_byte, b, counters[b], nnz);
+        if (b == n_passes) {
+            CAV_TRACE_SCOPE("move_uninit_span", cav::size(keys));
+            return ColumnsMover<0, n_cols>::move_all(buffs, cols);
+        }
+        b = columns_sort_lsd(buffs, cols, lo_byte, b, counters[b], nnz);
+    }
+}
+
+template <typename SzT,
+          typename C1,
+          typename C2,
+          typename K  = IdentityFtor,
+          typename St = NoSortStats>
+static void radix_sort_lsd(C1& cont, C2& buff, K key = {}, St&& stats = {}) {
+    static_assert(is_radix_ukey<sort::ukey_t<C1, K>>::value, "Key type must be unsigned");
+    constexpr size_t lo_byte  = sort::lo_byte<C1, K>();
+    constexpr size_t n_passes = sort::n_bytes<C1, K>() - lo_byte;
     assert(cav::size(cont) <= cav::size(buff));
     auto buff_span = make_span(std::begin(buff), cav::size(cont));
 
-    SzT counters[n_bytes][256] = {};
-    for (auto const& elem : cont)
-        for (uint8_t b = 0; b < n_bytes; ++b)
-            ++counters[b][nth_byte(to_uint(key(elem)), b)];
+    SzT counters[n_passes][256] = {};
+    {
+        CAV_TRACE_SCOPE("lsd_histogram", cav::size(cont));
+        size_t i = 0;
+        for (auto const& elem : cont) {
+            sort::prefetch_ahead(cont, key, i++);
+            auto ukey = to_uint(key(elem));
+            for (size_t b = 0; b < n_passes; ++b)
+                ++counters[b][nth_byte(ukey, lo_byte + b)];
+        }
+    }
 
-    SzT accum[n_bytes] = {};
-    SzT nnz[n_bytes]   = {};  // to skip bytes
+    SzT accum[n_passes] = {};
+    SzT nnz[n_passes]   = {};  // to skip bytes
     for (SzT i = 0; i < 256; ++i)
-        for (uint8_t b = 0; b < n_bytes; ++b) {
+        for (size_t b = 0; b < n_passes; ++b) {
             SzT old_count  = counters[b][i];
             counters[b][i] = accum[b];
             accum[b] += old_count;
             nnz[b] += old_count > 0;
         }
 
-    SzT b = 0;
-    for (; b < n_bytes;) {
-        b = byte_sort_lsd(cont, buff_span, key, b, counters[b], nnz);
-        if (b == n_bytes)
+    SzT n_run = 0;
+    for (size_t b = 0; b < n_passes; ++b)
+        n_run += nnz[b] > 1;
+    stats.add_passes(n_run, n_passes - n_run);
+    stats.add_moves(cav::size(cont) * (n_run + n_run % 2U), sizeof(sort::value_t<C1>));
+
+    size_t b = 0;
+    while (b < n_passes && nnz[b] <= 1)  // constant bytes need no pass
+        ++b;
+    while (b < n_passes) {
+        b = byte_sort_lsd(cont, buff_span, key, lo_byte, b, counters[b], nnz);
+        if (b == n_passes) {
+            CAV_TRACE_SCOPE("move_uninit_span", cav::size(cont));
             return move_uninit_span(cont, buff_span);
-        b = byte_sort_lsd(buff_span, cont, key, b, counters[b], nnz);
+        }
+        b = byte_sort_lsd(buff_span, cont, key, lo_byte, b, counters[b], nnz);
     }
 }
 
-template <typename SzT, typename C1, typename C2, typename K = IdentityFtor>
-static void radix_sort_msd(C1&     cont,
-                           C2&     buff,
-                           K       key = {},
-                           uint8_t b   = sizeof(sort::key_t<C1, K>) - 1) {
-    assert(b < sizeof(sort::key_t<C1, K>));
+template <typename SzT,
+          typename C1,
+          typename C2,
+          typename K  = IdentityFtor,
+          typename St = NoSortStats>
+static void radix_sort_msd(C1&    cont,
+                           C2&    buff,
+                           K      key   = {},
+                           size_t b     = sort::n_bytes<C1, K>() - 1,
+                           St&&   stats = {}) {
+    CAV_TRACE_SCOPE("msd_level", b);
+    constexpr size_t lo_byte = sort::lo_byte<C1, K>();
+    assert((lo_byte <= b && b < sort::n_bytes<C1, K>()));
     assert(cav::size(cont) <= cav::size(buff));
+    auto cmp_key   = sort::make_cmp_key<C1>(key);
     auto buff_span = make_span(std::begin(buff), cav::size(cont));
+    if (cav::size(cont) >= sizeof(sort::key_t<C1, K>) * 12) {
+        size_t old_b = b;
+        b            = skip_common_bytes(cont, key, b);
+        stats.add_passes(0, old_b - b);
+    }
 
     SzT  counts[256] = {};
-    auto srng        = byte_sort_msd(cont, buff_span, key, b, counts);
+    auto srng        = byte_sort_msd(cont, buff_span, key, b, counts, stats);
     if (srng.end == 0) {
-        assert_sorted(cont, key);
+        assert_sorted(cont, cmp_key);
         return;
     }
 
     assert(srng.beg < srng.end);
 
-    if (b == 0) {
+    if (b == lo_byte) {
+        CAV_TRACE_SCOPE("move_uninit_span", cav::size(cont));
         move_uninit_span(cont, buff_span);
-        assert_sorted(cont, key);
+        stats.add_moves(cav::size(cont), sizeof(sort::value_t<C1>));
+        assert_sorted(cont, cmp_key);
         return;
     }
 
@@ -130,19 +361,25 @@ static void radix_sort_msd(C1&     cont,
     for (SzT s = srng.beg; s < srng.end; sub_beg = counts[s++]) {
         if (sub_beg == counts[s])
             continue;
-        SzT  sub_counts[256] = {};
-        auto sub_buff        = make_span(buff_span, sub_beg, counts[s]);
-        auto sub_cont        = make_span(cont, sub_beg, counts[s]);
-        auto ssrng           = byte_sort_msd(sub_buff, sub_cont, key, b - 1, sub_counts);
+        SzT    sub_counts[256] = {};
+        auto   sub_buff        = make_span(buff_span, sub_beg, counts[s]);
+        auto   sub_cont        = make_span(cont, sub_beg, counts[s]);
+        size_t sb              = b - 1;
+        if (cav::size(sub_buff) >= sizeof(sort::key_t<C1, K>) * 12) {
+            sb = skip_common_bytes(sub_buff, key, sb);
+            stats.add_passes(0, b - 1 - sb);
+        }
+        auto ssrng = byte_sort_msd(sub_buff, sub_cont, key, sb, sub_counts, stats);
         if (ssrng.end == 0) {
             move_uninit_span(sub_cont, sub_buff);
-            assert_sorted(sub_cont, key);
+            stats.add_moves(cav::size(sub_cont), sizeof(sort::value_t<C1>));
+            assert_sorted(sub_cont, cmp_key);
             continue;
         }
         assert(ssrng.beg < ssrng.end);
 
-        if (b - 1 == 0) {
-            assert_sorted(sub_cont, key);
+        if (sb == lo_byte) {
+            assert_sorted(sub_cont, cmp_key);
             continue;
         }
 
@@ -150,18 +387,18 @@ static void radix_sort_msd(C1&     cont,
         for (SzT ss = ssrng.beg; ss < ssrng.end; sub_sub_beg = sub_counts[ss++]) {
             auto sub_sub_cont = make_span(sub_cont, sub_sub_beg, sub_counts[ss]);
             if (cav::size(sub_sub_cont) <= 4) {
-                net_dispatch(sub_sub_cont, key);
-                assert_sorted(sub_sub_cont, key);
+                net_dispatch(sub_sub_cont, cmp_key);
+                assert_sorted(sub_sub_cont, cmp_key);
                 continue;
             }
             // TODO(cava): consider calling the lsd radix sort when few bytes remains
             auto sub_sub_buff = make_span(sub_buff, sub_sub_beg, sub_counts[ss]);
-            radix_sort_msd<SzT>(sub_sub_cont, sub_sub_buff, key, b - 2);
-            assert_sorted(sub_sub_cont, key);
+            radix_sort_msd<SzT>(sub_sub_cont, sub_sub_buff, key, sb - 1, stats);
+            assert_sorted(sub_sub_cont, cmp_key);
         }
     }
 
-    assert_sorted(cont, key);
+    assert_sorted(cont, cmp_key);
 }
 }  // namespace cav
 
@@ -4,67 +4,197 @@
 #ifndef CAV_INCLUDE_RADIX_STUFF_HPP
 #define CAV_INCLUDE_RADIX_STUFF_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <memory>
+#include <tuple>
+#include <utility>
 
 #include "Span.hpp"
 #include "net_sort.hpp"
 #include "radix_sort.hpp"
+#include "sort_config.hpp"
+#include "sort_stats.hpp"
+#include "sort_trace.hpp"
 #include "sort_utils.hpp"
+#include "string_sort.hpp"
 #include "utils.hpp"
 
 #ifndef NDEBUG
-#include <algorithm>
-
 #include "limits.hpp"
 #endif
 
 namespace cav {
 
 /// @brief A class to sort and find the nth element of a container, it keeps a buffer for
-/// performance and it works with key instead of compartors.
-template <typename SzT = uint32_t, typename AlcT = std::allocator<char>>
+/// performance and it works with key instead of compartors. The stats policy StT (NoSortStats,
+/// SortStats or WorkloadCapture) records what each call does, see sort_stats.hpp and
+/// workload_capture.hpp.
+template <typename SzT  = uint32_t,
+          typename AlcT = std::allocator<char>,
+          typename StT  = NoSortStats>
 struct Sorter {
     static_assert(std::is_integral<SzT>::value, "SzT must be an integral type");
 
     using size_type  = SzT;
     using alloc_type = AlcT;
-
-    ///////// Internal buffer to speed up sorting operations + EBO for the allocator /////////
-    struct SorterData : alloc_type {
-        SorterData()                                 = default;
-        SorterData(SorterData const&)                = delete;
-        SorterData(SorterData&&) noexcept            = default;
-        SorterData& operator=(SorterData const&)     = delete;
-        SorterData& operator=(SorterData&&) noexcept = default;
+    using stats_type = StT;
+
+    ///////// Internal buffer to speed up sorting operations + EBO for allocator and stats /////////
+    /// The capacity is tracked in bytes (size_t, whatever SzT is) and grows geometrically, by 1.5x
+    /// at least, so slowly growing inputs do not reallocate at every call. Capacity above the
+    /// high-water mark is released by the first following call needing no more than the mark, so
+    /// that an occasional spike does not stay pinned for the lifetime of the Sorter.
+    struct SorterData : alloc_type, stats_type {
+        SorterData()                             = default;
+        SorterData(SorterData const&)            = delete;
+        SorterData& operator=(SorterData const&) = delete;
 
         explicit SorterData(alloc_type const& alc)
             : alloc_type(alc) {
         }
 
+        SorterData(SorterData&& other) noexcept
+            : alloc_type(std::move(static_cast<alloc_type&>(other)))
+            , stats_type(std::move(static_cast<stats_type&>(other)))
+            , cache_buff(other.cache_buff)
+            , buff_size(other.buff_size)
+            , high_water(other.high_water) {
+            other.cache_buff = nullptr;
+            other.buff_size  = 0;
+        }
+
+        SorterData& operator=(SorterData&& other) noexcept {
+            if (this == &other)
+                return *this;
+            _free();
+            static_cast<alloc_type&>(*this) = std::move(static_cast<alloc_type&>(other));
+            static_cast<stats_type&>(*this) = std::move(static_cast<stats_type&>(other));
+            cache_buff                      = other.cache_buff;
+            buff_size                       = other.buff_size;
+            high_water                      = other.high_water;
+            other.cache_buff                = nullptr;
+            other.buff_size                 = 0;
+            return *this;
+        }
+
         ~SorterData() {
-            std::allocator_traits<alloc_type>::deallocate(*this, cache_buff, buff_size);
+            _free();
         }
 
-        char* get_sized_buff(size_type char_sz) {
+        char* get_sized_buff(size_t char_sz) {
             if (char_sz > buff_size) {
-                std::allocator_traits<alloc_type>::deallocate(*this, cache_buff, buff_size);
-                cache_buff = std::allocator_traits<alloc_type>::allocate(*this, char_sz);
-                buff_size  = char_sz;
+                size_t grown = cav::max(char_sz, buff_size + buff_size / 2);
+                _realloc(char_sz <= high_water ? cav::max(char_sz, cav::min(grown, high_water))
+                                               : grown);
+            } else if (buff_size > high_water && char_sz <= high_water) {
+                release();
+                _realloc(char_sz);
             }
             return cache_buff;
         }
 
-        char* cache_buff = nullptr;
-        SzT   buff_size  = 0;
+        void reserve(size_t char_sz) {
+            if (char_sz > buff_size)
+                _realloc(char_sz);
+        }
+
+        void release() noexcept {
+            if (cache_buff == nullptr)
+                return;
+            _free();
+            stats_type::add_release();
+        }
+
+        char*  cache_buff = nullptr;
+        size_t buff_size  = 0;  // bytes
+        size_t high_water = std::numeric_limits<size_t>::max();
+
+    private:
+        void _realloc(size_t char_sz) {
+            _free();
+            cache_buff = std::allocator_traits<alloc_type>::allocate(*this, char_sz);
+            buff_size  = char_sz;
+            stats_type::add_realloc(char_sz);
+        }
+
+        void _free() noexcept {
+            if (cache_buff != nullptr)
+                std::allocator_traits<alloc_type>::deallocate(*this, cache_buff, buff_size);
+            cache_buff = nullptr;
+            buff_size  = 0;
+        }
     } data;
 
+    stats_type& stats() noexcept {
+        return data;
+    }
+
+    stats_type const& stats() const noexcept {
+        return data;
+    }
+
+    alloc_type const& get_allocator() const noexcept {
+        return data;
+    }
+
+    /// @brief Bytes of the working buffer currently held.
+    size_t capacity() const noexcept {
+        return data.buff_size;
+    }
+
+    /// @brief Grows the working buffer to `bytes` at least, e.g., `n * sizeof(T)` before the radix
+    /// sorts of n values of type T, so that the first call does not pay for the allocation.
+    void reserve(size_t bytes) {
+        data.reserve(bytes);
+    }
+
+    /// @brief Releases the working buffer, the next call that needs one allocates it again.
+    void shrink_to_fit() noexcept {
+        data.release();
+    }
+
+    /// @brief Capacity retained between calls: a buffer grown above `bytes` by a larger call is
+    /// released (and reallocated to size) by the next call needing at most `bytes`, and the
+    /// geometric growth never overshoots it. Unlimited by default.
+    void set_high_water_mark(size_t bytes) noexcept {
+        data.high_water = bytes;
+    }
+
+    size_t high_water_mark() const noexcept {
+        return data.high_water;
+    }
+
+protected:
+    /// @brief insertion_sort recorded by the stats, for the dispatch of sort() and AdaptiveSorter.
+    template <typename C, typename K>
+    void _insertion_sort(C& container, K key) {
+        auto start = stats().start();
+        cav::insertion_sort(container, stats().wrap_key(key));
+        stats().stop(SortAlgo::insertion, cav::size(container), start);
+    }
+
 private:
+    /// @brief Bytes of a column of n values in the working buffer (cache line aligned).
+    template <typename T>
+    static size_t _column_bytes(size_t n) {
+        return (n * sizeof(T) + 63U) / 64U * 64U;
+    }
+
+    /// @brief Column of n values at `offs` in `raw`, moving `offs` past it.
+    template <typename T>
+    static Span<T*> _column_span(char* raw, size_t& offs, size_t n) {
+        auto* beg = reinterpret_cast<T*>(raw + offs);
+        offs += _column_bytes<T>(n);
+        return make_span(beg, n);
+    }
+
     /// @brief Provide a working buffer maintained between calls to avoid reallocations
     template <typename T>
-    Span<T*> _get_span(size_type sz) {
+    Span<T*> _get_span(size_t sz) {
         return make_span(reinterpret_cast<T*>(data.get_sized_buff(sz * sizeof(T))), sz);
     }
 
@@ -99,10 +229,10 @@ private:
     }
 
 
-public:
-    template <typename C, typename K = IdentityFtor>
-    void dutch_nth_elem(C& container, size_type nth, K key = {}) {
-        constexpr size_type n_bytes  = sizeof(sort::key_t<C, K>);
+    template <typename C, typename K>
+    void _dutch_nth_elem(C& container, size_type nth, K key) {
+        constexpr size_type n_bytes  = sort::n_bytes<C, K>();
+        constexpr size_type lo_byte  = sort::lo_byte<C, K>();
         size_type           nth_copy = nth;
 
         size_type counters[256] = {};
@@ -112,7 +242,7 @@ public:
             ++counters[nth_byte<n_bytes - 1U>(key_buff[i])];
         }
 
-        for (size_type b = 0; b < n_bytes; ++b) {
+        for (size_type b = 0; b < n_bytes - lo_byte; ++b) {
             uint8_t   median      = 0;
             size_type bucket_size = 0;
             for (size_type i = 0; i < 256; ++i) {
@@ -150,12 +280,12 @@ public:
     ////////////////////////////// RADIX NTH ELEMENT /////////////////////////////////////
 private:
     template <typename C1, typename C2, size_type Nm>
-    static void _unwind_moves(C1&     cont1,
-                              C2&     cont2,
-                              uint8_t ibeg,
+    static void _unwind_moves(C1&    cont1,
+                              C2&    cont2,
+                              size_t ibeg,
                               size_type (&begs)[Nm],
                               size_type (&ends)[Nm]) {
-        for (uint8_t i = ibeg; i < Nm; ++i) {
+        for (size_t i = ibeg; i < Nm; ++i) {
             move_uninit_span(make_span(cont1, begs[i], ends[i]),
                              make_span(cont2, begs[i], ends[i]));
             if (++i >= Nm)
@@ -174,7 +304,8 @@ private:
                                size_type (&counters)[2][256],
                                size_type (&beg)[Nm],
                                size_type (&end)[Nm]) {
-        constexpr size_type n_bytes = sizeof(sort::key_t<C1, K>);
+        constexpr size_type n_bytes = sort::n_bytes<C1, K>();
+        constexpr size_type lo_byte = sort::lo_byte<C1, K>();
 
         bool      active_c = (n_bytes - 1 - b) & 1U;
         size_type total    = beg[b + 1];
@@ -191,7 +322,7 @@ private:
         for (size_type j = beg[b + 1]; j < end[b + 1]; ++j) {
             auto&   elem   = cont1[j];
             uint8_t k      = nth_byte(to_uint(key(elem)), b);
-            uint8_t next_k = nth_byte(to_uint(key(elem)), max(1U, b) - 1U);
+            uint8_t next_k = nth_byte(to_uint(key(elem)), max(lo_byte + 1U, b) - 1U);
             assert(beg[b + 1] <= counters[active_c][k] && counters[active_c][k] < end[b + 1]);
             move_uninit(cont2[counters[active_c][k]], elem);
             ++counters[active_c][k];
@@ -200,10 +331,10 @@ private:
         end[b] = counters[active_c][median];
     }
 
-public:
-    template <typename C, typename K = IdentityFtor>
-    void radix_nth_elem(C& container, size_type nth, K key = {}) {
-        constexpr size_type n_bytes = sizeof(sort::key_t<C, K>);
+    template <typename C, typename K>
+    void _radix_nth_elem(C& container, size_type nth, K key) {
+        constexpr size_type n_bytes = sort::n_bytes<C, K>();
+        constexpr size_type lo_byte = sort::lo_byte<C, K>();
 
         size_type counters[2][256] = {};
         for (auto const& elem : container)
@@ -215,64 +346,250 @@ public:
 
         for (size_type b = n_bytes - 1;;) {
             _byte_nth_elem(container, val_buff, nth, key, b, counters, begs, ends);
-            if (ends[b] - begs[b] == 1 || b == 0)
+            if (ends[b] - begs[b] == 1 || b == lo_byte)
                 return _unwind_moves(container, val_buff, b + 1, begs, ends);
             --b;
             _byte_nth_elem(val_buff, container, nth, key, b, counters, begs, ends);
-            if (ends[b] - begs[b] == 1 || b == 0)
+            if (ends[b] - begs[b] == 1 || b == lo_byte)
                 return _unwind_moves(val_buff, container, b + 1, begs, ends);
             --b;
         }
-        assert_nth_elem(container, nth, key);
+        assert_nth_elem(container, nth, sort::make_cmp_key<C>(key));
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////// KEY/INDEX SORT /////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////
+private:
+    /// @brief Handle sorted in place of a value: its key and its position in the container.
+    template <typename KeyT>
+    struct KeyIndex {
+        KeyT      key;
+        size_type idx;
+    };
+
+    struct KeyIndexKey {
+        template <typename KeyT>
+        KeyT operator()(KeyIndex<KeyT> const& handle) const noexcept {
+            return handle.key;
+        }
+    };
+
+    /// @brief Builds the (key, index) handles of the values in the first half of `buff` and sorts
+    /// them with the LSD radix sort (stable, the handles are small), using the second half as its
+    /// buffer. Each key is computed once.
+    template <typename C, typename K, typename H>
+    Span<H*> _sort_handles(C& container, K key, Span<H*> buff) {
+        size_type n   = cav::size(container);
+        auto      hs  = make_span(buff, 0, n);
+        auto      beg = std::begin(container);
+        for (size_type i = 0; i < n; ++i)
+            ::new (std::addressof(hs[i])) H{key(beg[i]), i};
+
+        auto hbuff = make_span(buff, n, 2 * n);
+        cav::radix_sort_lsd<size_type>(hs, hbuff, KeyIndexKey{}, stats());
+        return hs;
+    }
+
+    /// @brief Values expensive to move: they are moved in place along the permutation cycles.
+    template <typename C, typename K>
+    auto _key_index_sort(C& container, K key)
+        -> CAV_REQUIRES(!std::is_trivially_copyable<sort::value_t<C>>::value) {
+        // Handles + radix buffer, counted in size_t: 2n overflows a 32-bit size_type
+        using handle_t = KeyIndex<sort::key_t<C, K>>;
+        auto buff      = _get_span<handle_t>(size_t{2} * cav::size(container));
+        auto hs        = _sort_handles(container, key, buff);
+        _apply_permutation(container, hs);
+    }
+
+    /// @brief Large trivially copyable records: they are gathered into the buffer in sorted order
+    /// and copied back, i.e., each record is copied twice, sequentially written both times.
+    template <typename C, typename K>
+    auto _key_index_sort(C& container, K key)
+        -> CAV_REQUIRES(std::is_trivially_copyable<sort::value_t<C>>::value) {
+        using value_type = sort::value_t<C>;
+        using handle_t   = KeyIndex<sort::key_t<C, K>>;
+        size_t n         = cav::size(container);
+        size_t align     = alignof(handle_t);
+        size_t v_size    = (n * sizeof(value_type) + align - 1) / align * align;
+        char*  raw       = data.get_sized_buff(v_size + 2 * n * sizeof(handle_t));
+        auto   vals      = make_span(reinterpret_cast<value_type*>(raw), n);
+        auto   buff      = make_span(reinterpret_cast<handle_t*>(raw + v_size), 2 * n);
+        auto   hs        = _sort_handles(container, key, buff);
+        _gather(container, hs, vals);
+        CAV_TRACE_SCOPE("move_uninit_span", n);
+        move_uninit_span(container, vals);
+        stats().add_moves(2 * n, sizeof(value_type));
+    }
+
+    /// @brief Copies the records into `vals` in the order of the handles, a block of about 4 KiB
+    /// at a time: all the cache lines of the records of the next block are prefetched while the
+    /// current block is copied, so the random reads overlap.
+    template <typename C, typename H, typename V>
+    static void _gather(C const& container, H const& handles, V& vals) {
+        using value_type = sort::value_t<C>;
+        CAV_TRACE_SCOPE("gather", cav::size(container));
+        constexpr size_t block = sizeof(value_type) >= 4096 ? 1 : 4096 / sizeof(value_type);
+        size_t           n     = cav::size(container);
+        auto             beg   = std::begin(container);
+        for (size_t i = 0; i < min(block, n); ++i)
+            prefetch_bytes(std::addressof(beg[handles[i].idx]), sizeof(value_type));
+        for (size_t b = 0; b < n; b += block) {
+            size_t end = min(b + block, n);
+            for (size_t i = end; i < min(end + block, n); ++i)
+                prefetch_bytes(std::addressof(beg[handles[i].idx]), sizeof(value_type));
+            for (size_t i = b; i < end; ++i)
+                std::memcpy(std::addressof(vals[i]),
+                            std::addressof(beg[handles[i].idx]),
+                            sizeof(value_type));
+        }
+    }
+
+    /// @brief Moves the values so that the i-th one is the handles[i].idx-th one, following the
+    /// cycles of the permutation: one move per displaced value plus one (and a destruction) per
+    /// cycle. The handle indexes are overwritten to mark the visited positions.
+    template <typename C, typename H>
+    void _apply_permutation(C& container, H& handles) {
+        CAV_TRACE_SCOPE("apply_permutation", cav::size(container));
+        size_type n     = cav::size(container);
+        size_type moved = 0;
+        auto      beg   = std::begin(container);
+        for (size_type i = 0; i < n; ++i) {
+            if (handles[i].idx == i)
+                continue;
+            auto      tmp = std::move(beg[i]);
+            size_type dst = i;
+            for (;;) {
+                size_type src    = handles[dst].idx;
+                handles[dst].idx = dst;
+                ++moved;
+                if (src == i) {
+                    beg[dst] = std::move(tmp);
+                    break;
+                }
+                beg[dst] = std::move(beg[src]);
+                dst      = src;
+            }
+        }
+        stats().add_moves(moved, sizeof(sort::value_t<C>));
     }
 
 public:
+    template <typename C, typename K = IdentityFtor>
+    void dutch_nth_elem(C& container, size_type nth, K key = {}) {
+        auto start = stats().start();
+        _dutch_nth_elem(container, nth, stats().wrap_key(key));
+        stats().stop(NthAlgo::dutch, cav::size(container), start);
+    }
+
+    template <typename C, typename K = IdentityFtor>
+    void radix_nth_elem(C& container, size_type nth, K key = {}) {
+        auto start = stats().start();
+        _radix_nth_elem(container, nth, stats().wrap_key(key));
+        stats().stop(NthAlgo::radix, cav::size(container), start);
+    }
+
     template <typename C, typename K = IdentityFtor>
     void radix_sort_lsd(C& container, K key = {}) {
+        auto start    = stats().start();
         auto val_buff = _get_span<sort::value_t<C>>(cav::size(container));
-        cav::radix_sort_lsd<size_type>(container, val_buff, key);
+        cav::radix_sort_lsd<size_type>(container, val_buff, stats().wrap_key(key), stats());
+        stats().stop(SortAlgo::radix_lsd, cav::size(container), start);
     }
 
     template <typename C, typename K = IdentityFtor>
     void radix_sort_msd(C& container, K key = {}) {
-        auto val_buff = _get_span<sort::value_t<C>>(cav::size(container));
-        cav::radix_sort_msd<size_type>(container, val_buff, key);
+        constexpr size_t msb      = sort::n_bytes<C, K>() - 1;
+        auto             start    = stats().start();
+        auto             val_buff = _get_span<sort::value_t<C>>(cav::size(container));
+        cav::radix_sort_msd<size_type>(container, val_buff, stats().wrap_key(key), msb, stats());
+        stats().stop(SortAlgo::radix_msd, cav::size(container), start);
+    }
+
+    /// @brief Sorts the `keys` column by its values and reorders each of the `payloads` columns
+    /// (of the same size) in the same way, scattering all of them in the same LSD radix passes:
+    /// sort_by_key over a structure of arrays, without building records or a permutation. Stable.
+    template <typename KC, typename... PCs>
+    void sort_by_key(KC& keys, PCs&... payloads) {
+        size_t n = cav::size(keys);
+        for (size_t sz : {n, static_cast<size_t>(cav::size(payloads))...}) {
+            assert(sz == n && "Columns of different sizes");
+            static_cast<void>(sz);  // NDEBUG
+        }
+
+        auto   start = stats().start();
+        size_t bytes = _column_bytes<sort::value_t<KC>>(n);
+        for (size_t col : {size_t{0}, _column_bytes<sort::value_t<PCs>>(n)...})
+            bytes += col;
+        char*  raw   = data.get_sized_buff(bytes);
+        size_t offs  = 0;
+        auto   buffs = std::tuple<Span<sort::value_t<KC>*>, Span<sort::value_t<PCs>*>...>{
+            _column_span<sort::value_t<KC>>(raw, offs, n),
+            _column_span<sort::value_t<PCs>>(raw, offs, n)...};  // braces: left to right
+        cav::radix_sort_lsd_columns<size_type>(
+            std::make_tuple(make_span(keys, 0, n), make_span(payloads, 0, n)...), buffs, stats());
+        stats().stop(SortAlgo::radix_lsd, n, start);
     }
 
     template <typename C, typename K = IdentityFtor>
-    void net_sort(C& container, K key = {}) {
-        if (cav::size(container) <= CAV_MAX_NET_SIZE)
-            return net_dispatch(container, key);
+    void radix_sort_str(C& container, K key = {}) {
+        auto start   = stats().start();
+        auto entries = _get_span<StrEntry<sort::value_t<C>>>(size_t{2} * cav::size(container));
+        cav::radix_sort_str<size_type>(container, entries, stats().wrap_key(key));
+        stats().stop(SortAlgo::radix_str, cav::size(container), start);
+    }
 
-        auto buff = _get_span<sort::value_t<C>>(cav::size(container));
-        cav::net_sort<size_type>(container, buff, key);
+    /// @brief Sorts (key, index) handles instead of the values, then puts each value in its place
+    /// once: values that are not trivially copyable (e.g., holding a std::string), which the radix
+    /// sorts would move-construct and destroy at every pass, are moved along the permutation
+    /// cycles; trivially copyable records are gathered into the buffer and copied back. Meant for
+    /// values expensive to move and records larger than a cache line.
+    template <typename C, typename K = IdentityFtor>
+    void key_index_sort(C& container, K key = {}) {
+        auto start = stats().start();
+        _key_index_sort(container, stats().wrap_key(key));
+        stats().stop(SortAlgo::key_index, cav::size(container), start);
+    }
+
+    template <typename C, typename K = IdentityFtor>
+    void net_sort(C& container, K key = {}) {
+        auto start = stats().start();
+        if (cav::size(container) <= CAV_MAX_NET_SIZE) {
+            net_dispatch(container, sort::make_cmp_key<C>(stats().wrap_key(key)));
+        } else {
+            auto buff = _get_span<sort::value_t<C>>(cav::size(container));
+            cav::net_sort<size_type>(container, buff, stats().wrap_key(key), stats());
+        }
+        stats().stop(SortAlgo::net_sort, cav::size(container), start);
     }
 
+    /// @brief Plain cav::insertion_sort, usable without a Sorter (not recorded by the stats).
     template <typename C, typename K = IdentityFtor>
     static void insertion_sort(C& container, K key = {}) {
         cav::insertion_sort(container, key);
     }
 
-    static constexpr size_t msd_rdx_val_size_thresh[] = {(1ULL << 63U),  // < 8byte
-                                                         (1ULL << 42U),  // 8 bytes
-                                                         (1ULL << 26U),  // 16 bytes
-                                                         (1ULL << 22U),
-                                                         (1ULL << 18U),  // 32 bytes
-                                                         (1ULL << 14U),
-                                                         (1ULL << 12U),
-                                                         (1ULL << 10U),
-                                                         (1ULL << 8U)};  // 64 bytes
-
     template <typename C, typename K = IdentityFtor>
-    auto sort(C& container, K key = {}) -> CAV_REQUIRES(
-        std::is_same<sort::value_t<C>, sort::key_t<C, K>>::value&& std::is_empty<K>::value) {
-        // Best effort to detect containers of native types using themselves as a key
+    void std_sort(C& container, K key = {}) {
+        auto start = stats().start();
+        std::sort(std::begin(container),
+                  std::end(container),
+                  sort::make_comp_wrap(sort::make_cmp_key<C>(stats().wrap_key(key))));
+        stats().stop(SortAlgo::std_sort, cav::size(container), start);
+    }
+
+    // Thresholds from sort_config.hpp (handpicked defaults or generated by the autotune target)
+    static constexpr size_t msd_rdx_val_size_thresh[] = CAV_MSD_RDX_VAL_SIZE_THRESH;
+    static_assert(sizeof(msd_rdx_val_size_thresh) == 9 * sizeof(size_t), "One entry per 8 bytes");
 
+    template <typename C, typename K = IdentityFtor>
+    auto sort(C& container, K key = {}) -> CAV_REQUIRES(sort::is_self_keyed<C, K>::value) {
         assert(cav::size(container) < limits<size_type>::max() && "Container size exceeds SizeT "
                                                                   "max");
+        stats().observe(container, key);
 
         // Native types are usually better handled with sorting networks + lsd radix sort
-        if (cav::size(container) < sizeof(sort::key_t<C, K>) * 24)
+        if (cav::size(container) < sizeof(sort::key_t<C, K>) * CAV_NET_SORT_KEY_FACTOR)
             net_sort(container, key);
         else
             radix_sort_lsd(container, key);
@@ -280,28 +597,40 @@ public:
 
     template <typename C, typename K = IdentityFtor>
     auto sort(C& container, K key = {})
-        -> CAV_REQUIRES(!(std::is_same<sort::value_t<C>, sort::key_t<C, K>>::value &&
-                          std::is_empty<K>::value)) {
+        -> CAV_REQUIRES(!sort::is_self_keyed<C, K>::value) {
         assert(cav::size(container) < limits<size_type>::max() && "Container size exceeds SizeT "
                                                                   "max");
+        stats().observe(container, key);
 
-        static constexpr size_t val_size = sizeof(sort::value_t<C>);
+        static constexpr size_t val_size    = sizeof(sort::value_t<C>);
+        static constexpr size_t handle_size = sizeof(KeyIndex<sort::key_t<C, K>>);
         // In other scenarios, insertion_sort does a better job for small containers
-        if (cav::size(container) < sizeof(sort::key_t<C, K>) * 18)
+        if (cav::size(container) < sizeof(sort::key_t<C, K>) * CAV_SMALL_SORT_KEY_FACTOR)
             if (std::is_empty<K>::value)
-                insertion_sort(container, key);
+                _insertion_sort(container, key);
             else
                 radix_sort_msd(container, key);
 
-        // If the type is larger than a cache-line std::sort is still the best option
+        // Values expensive to move and larger than their handles: sort (key, index) handles and
+        // move each value once, as long as the permutation cycles are walked mostly in cache
+        else if (!std::is_trivially_copyable<sort::value_t<C>>::value && val_size > handle_size &&
+                 cav::size(container) * (val_size + handle_size) <= CAV_KEY_INDEX_MAX_BYTES)
+            key_index_sort(container, key);
+
+        // Records larger than a cache-line: radix sort (key, index) handles, then gather the
+        // records once instead of moving them at every pass (or O(N log N) times with std::sort)
         else if (val_size > 64U)
-            std::sort(std::begin(container), std::end(container), sort::make_comp_wrap(key));
+            if (cav::size(container) < CAV_KEY_INDEX_MIN_SIZE ||
+                !std::is_trivially_copyable<sort::value_t<C>>::value)
+                std_sort(container, key);
+            else
+                key_index_sort(container, key);
 
         else {
             // Key does not have state -> probably a field of a struct
             //                    else -> probably indirect key
             size_t msd_rdx_thresh = std::is_empty<K>::value ? msd_rdx_val_size_thresh[val_size / 8U]
-                                                            : (1ULL << 22U);
+                                                            : CAV_MSD_RDX_INDIRECT_THRESH;
 
 
             // If the key is smaller than 8 bytes or the type is relatively small -> lsd radix sort
@@ -312,19 +641,19 @@ public:
             else
                 radix_sort_msd(container, key);
         }
-        assert_sorted(container, key);
+        assert_sorted(container, sort::make_cmp_key<C>(key));
     }
 
     template <typename C, typename K = IdentityFtor>
     void nth_element(C& container, size_type nth, K key = {}) {
         assert(cav::size(container) < limits<size_type>::max() && "Container size exceeds SizeT "
                                                                   "max");
-        if (cav::size(container) < 48U)
+        if (cav::size(container) < CAV_NTH_ELEM_SORT_THRESH)
             sort(container, key);
         else
             radix_nth_elem(container, nth, key);
 
-        assert_nth_elem(container, nth, key);
+        assert_nth_elem(container, nth, sort::make_cmp_key<C>(key));
     }
 };
 
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_SORT_CONFIG_HPP
+#define CAV_INCLUDE_SORT_CONFIG_HPP
+
+/// Thresholds used by Sorter to pick an algorithm. The defaults have been handpicked on an
+/// i7-13700H; run the `autotune` target to measure them on the host and generate a header with the
+/// crossover points, then point CAV_TUNED_CONFIG to it (CMake: -DCAV_TUNED_CONFIG=<path>).
+/// Each value can also be overridden alone by defining it before including sort.hpp.
+
+#ifdef CAV_TUNED_CONFIG
+#include CAV_TUNED_CONFIG
+#endif
+
+/// Self-keyed (native) types: sorting networks below sizeof(key) * factor elements, LSD above.
+#ifndef CAV_NET_SORT_KEY_FACTOR
+#define CAV_NET_SORT_KEY_FACTOR 24U
+#endif
+
+/// Other types: insertion sort (MSD for stateful keys) below sizeof(key) * factor elements.
+#ifndef CAV_SMALL_SORT_KEY_FACTOR
+#define CAV_SMALL_SORT_KEY_FACTOR 18U
+#endif
+
+/// Minimum size from which MSD is preferred over LSD, indexed by sizeof(value) / 8 (up to 64B).
+/// The handpicked values stay available, for the entries the autotune target cannot measure.
+#define CAV_MSD_RDX_VAL_SIZE_THRESH_DEFAULT                                                    \
+    {(1ULL << 63U), (1ULL << 42U), (1ULL << 26U), (1ULL << 22U), (1ULL << 18U), (1ULL << 14U), \
+     (1ULL << 12U), (1ULL << 10U), (1ULL << 8U)}
+#ifndef CAV_MSD_RDX_VAL_SIZE_THRESH
+#define CAV_MSD_RDX_VAL_SIZE_THRESH CAV_MSD_RDX_VAL_SIZE_THRESH_DEFAULT
+#endif
+
+/// Minimum size from which MSD is preferred over LSD for stateful (likely indirect) keys.
+#ifndef CAV_MSD_RDX_INDIRECT_THRESH
+#define CAV_MSD_RDX_INDIRECT_THRESH (1ULL << 22U)
+#endif
+
+/// Not trivially copyable values are sorted through (key, index) handles (Sorter::key_index_sort)
+/// up to this many bytes of values and handles; above, the permutation walk misses the cache.
+#ifndef CAV_KEY_INDEX_MAX_BYTES
+#define CAV_KEY_INDEX_MAX_BYTES (32ULL << 20U)
+#endif
+
+/// Records larger than a cache line are sorted through (key, index) handles from this size, with
+/// std::sort below it.
+#ifndef CAV_KEY_INDEX_MIN_SIZE
+#define CAV_KEY_INDEX_MIN_SIZE 512U
+#endif
+
+/// Elements ahead of the current one whose key the radix passes prefetch, for keys that support it
+/// (see IndirectKey in sort_utils.hpp).
+#ifndef CAV_KEY_PREFETCH_DIST
+#define CAV_KEY_PREFETCH_DIST 16U
+#endif
+
+/// nth_element fully sorts containers smaller than this.
+#ifndef CAV_NTH_ELEM_SORT_THRESH
+#define CAV_NTH_ELEM_SORT_THRESH 48U
+#endif
+
+#endif /* CAV_INCLUDE_SORT_CONFIG_HPP */
@@ -0,0 +1,186 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_SORT_STATS_HPP
+#define CAV_INCLUDE_SORT_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace cav {
+
+/// @brief Sorting algorithms Sorter can dispatch to.
+enum class SortAlgo : uint8_t {
+    net_sort,
+    radix_lsd,
+    radix_msd,
+    insertion,
+    std_sort,
+    key_index,
+    radix_str,  // string keys only, after the algorithms for any key
+    count
+};
+
+/// @brief Nth element algorithms Sorter can dispatch to.
+enum class NthAlgo : uint8_t {
+    radix,
+    dutch,
+    count
+};
+
+/// @brief Default stats policy of Sorter: every hook is an empty inline function, so the
+/// instrumentation compiles to nothing (and the empty base takes no space in Sorter).
+struct NoSortStats {
+    struct Timer {};
+
+    template <typename K>
+    static K wrap_key(K key) noexcept {
+        return key;
+    }
+
+    static Timer start() noexcept {
+        return {};
+    }
+
+    static void stop(SortAlgo /*algo*/, size_t /*n*/, Timer /*start*/) noexcept {
+    }
+
+    static void stop(NthAlgo /*algo*/, size_t /*n*/, Timer /*start*/) noexcept {
+    }
+
+    static void add_moves(size_t /*n_elems*/, size_t /*elem_size*/) noexcept {
+    }
+
+    static void add_passes(size_t /*run*/, size_t /*skipped*/) noexcept {
+    }
+
+    static void add_fallback() noexcept {
+    }
+
+    static void add_realloc(size_t /*bytes*/) noexcept {
+    }
+
+    static void add_release() noexcept {
+    }
+
+    template <typename C, typename K>
+    static void observe(C const& /*container*/, K /*key*/) noexcept {
+    }
+};
+
+/// @brief Key functor adaptor counting its invocations.
+template <typename K>
+struct CountingKey {
+    K         key;
+    uint64_t* count;
+
+    template <typename T>
+    auto operator()(T const& v) -> decltype(std::declval<K&>()(v)) {
+        ++*count;
+        return key(v);
+    }
+
+    template <typename T, typename K2 = K>
+    auto prefetch(T const& v) -> decltype(std::declval<K2&>().prefetch(v)) {
+        key.prefetch(v);
+    }
+};
+
+/// @brief Stats policy of Sorter that records what each call did. Read it through
+/// Sorter::stats(); all the counters are cumulative until reset().
+struct SortStats {
+    using clock = std::chrono::steady_clock;
+    using Timer = clock::time_point;
+
+    struct AlgoStats {
+        uint64_t calls = 0;
+        uint64_t elems = 0;
+        uint64_t ns    = 0;
+    };
+
+    AlgoStats sort_algos[static_cast<uint8_t>(SortAlgo::count)] = {};
+    AlgoStats nth_algos[static_cast<uint8_t>(NthAlgo::count)]   = {};
+    uint64_t  elems_moved         = 0;  // by scatter and merge passes
+    uint64_t  bytes_moved         = 0;
+    uint64_t  passes_run          = 0;  // radix scatter passes
+    uint64_t  passes_skipped      = 0;  // radix bytes skipped (constant or common prefix)
+    uint64_t  insertion_fallbacks = 0;  // MSD buckets left to insertion sort
+    uint64_t  key_calls           = 0;
+    uint64_t  buff_reallocs       = 0;
+    uint64_t  buff_releases       = 0;  // shrink_to_fit or high-water mark trims
+    uint64_t  buff_bytes          = 0;  // size of the working buffer
+    uint64_t  buff_peak_bytes     = 0;  // largest working buffer held
+    uint64_t  buff_alloc_bytes    = 0;  // cumulative bytes requested to the allocator
+
+    template <typename K>
+    CountingKey<K> wrap_key(K key) noexcept {
+        return {key, &key_calls};
+    }
+
+    static Timer start() noexcept {
+        return clock::now();
+    }
+
+    void stop(SortAlgo algo, size_t n, Timer start) noexcept {
+        _add_call(sort_algos[static_cast<uint8_t>(algo)], n, start);
+    }
+
+    void stop(NthAlgo algo, size_t n, Timer start) noexcept {
+        _add_call(nth_algos[static_cast<uint8_t>(algo)], n, start);
+    }
+
+    void add_moves(size_t n_elems, size_t elem_size) noexcept {
+        elems_moved += n_elems;
+        bytes_moved += n_elems * elem_size;
+    }
+
+    void add_passes(size_t run, size_t skipped) noexcept {
+        passes_run += run;
+        passes_skipped += skipped;
+    }
+
+    void add_fallback() noexcept {
+        ++insertion_fallbacks;
+    }
+
+    void add_realloc(size_t bytes) noexcept {
+        ++buff_reallocs;
+        buff_alloc_bytes += bytes;
+        buff_bytes      = bytes;
+        buff_peak_bytes = bytes > buff_peak_bytes ? bytes : buff_peak_bytes;
+    }
+
+    void add_release() noexcept {
+        ++buff_releases;
+        buff_bytes = 0;
+    }
+
+    template <typename C, typename K>
+    static void observe(C const& /*container*/, K /*key*/) noexcept {
+    }
+
+    AlgoStats const& of(SortAlgo algo) const noexcept {
+        return sort_algos[static_cast<uint8_t>(algo)];
+    }
+
+    AlgoStats const& of(NthAlgo algo) const noexcept {
+        return nth_algos[static_cast<uint8_t>(algo)];
+    }
+
+    void reset() noexcept {
+        *this = SortStats{};
+    }
+
+private:
+    static void _add_call(AlgoStats& as, size_t n, Timer start) noexcept {
+        ++as.calls;
+        as.elems += n;
+        as.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+    }
+};
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_SORT_STATS_HPP */
@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_SORT_TRACE_HPP
+#define CAV_INCLUDE_SORT_TRACE_HPP
+
+/// Optional timeline tracing of the sorting phases (histograms, scatter passes, MSD levels,
+/// network chunks, merge levels, final moves). Define CAV_SORT_TRACE before including any header
+/// of the library to enable it; otherwise CAV_TRACE_SCOPE expands to nothing.
+/// Each thread appends its events to its own buffer without locking (a mutex is taken only the
+/// first time a thread records an event). Export with cav::trace::write_chrome_json() once the
+/// traced sorts are done, and open the file in chrome://tracing or ui.perfetto.dev.
+
+#define CAV_TRACE_CAT_IMPL(a, b) a##b
+#define CAV_TRACE_CAT(a, b)      CAV_TRACE_CAT_IMPL(a, b)
+
+#ifndef CAV_SORT_TRACE
+
+#define CAV_TRACE_SCOPE(name, arg) static_cast<void>(0)
+
+#else
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#define CAV_TRACE_SCOPE(name, arg) \
+    ::cav::trace::Scope CAV_TRACE_CAT(cav_trace_scope_, __LINE__)(name, arg)
+
+namespace cav {
+namespace trace {
+
+    using clock = std::chrono::steady_clock;
+
+    struct Event {
+        char const* name;  // string literal
+        uint64_t    arg;   // phase specific: elements, byte or merge size
+        uint64_t    beg_ns;
+        uint64_t    dur_ns;
+    };
+
+    struct ThreadBuffer {
+        uint32_t           tid;
+        std::vector<Event> events;
+    };
+
+    struct Registry {
+        std::mutex                                 mtx;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        clock::time_point                          epoch = clock::now();
+    };
+
+    inline Registry& registry() {
+        static Registry reg;
+        return reg;
+    }
+
+    /// @brief Buffer of the calling thread, registered on first use. The registry shares its
+    /// ownership, so the events survive the thread.
+    inline ThreadBuffer& thread_buffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buff;
+        if (!buff) {
+            Registry&                   reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mtx);
+            buff      = std::make_shared<ThreadBuffer>();
+            buff->tid = static_cast<uint32_t>(reg.buffers.size());
+            buff->events.reserve(1U << 12U);
+            reg.buffers.push_back(buff);
+        }
+        return *buff;
+    }
+
+    inline uint64_t now_ns() {
+        auto elapsed = clock::now() - registry().epoch;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+    /// @brief Records a complete event spanning its lifetime.
+    class Scope {
+    public:
+        Scope(char const* scope_name, uint64_t scope_arg)
+            : name(scope_name)
+            , arg(scope_arg)
+            , beg_ns(now_ns()) {
+        }
+
+        Scope(Scope const&)            = delete;
+        Scope& operator=(Scope const&) = delete;
+
+        ~Scope() {
+            uint64_t end_ns = now_ns();
+            thread_buffer().events.push_back({name, arg, beg_ns, end_ns - beg_ns});
+        }
+
+    private:
+        char const* name;
+        uint64_t    arg;
+        uint64_t    beg_ns;
+    };
+
+    /// @brief Drops the recorded events. Not thread-safe w.r.t. threads still tracing.
+    inline void clear() {
+        Registry&                   reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        for (auto& buff : reg.buffers)
+            buff->events.clear();
+    }
+
+    /// @brief Writes the recorded events in the Chrome trace event format (JSON object format).
+    /// Not thread-safe w.r.t. threads still tracing.
+    inline void write_chrome_json(std::ostream& out) {
+        Registry&                   reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        char const* sep = "\n";
+        for (auto const& buff : reg.buffers)
+            for (Event const& e : buff->events) {
+                out << sep << "{\"name\":\"" << e.name << "\",\"cat\":\"sort\",\"ph\":\"X\""
+                    << ",\"pid\":1,\"tid\":" << buff->tid << ",\"ts\":" << e.beg_ns / 1e3
+                    << ",\"dur\":" << e.dur_ns / 1e3 << ",\"args\":{\"n\":" << e.arg << "}}";
+                sep = ",\n";
+            }
+        out << "\n]}\n";
+    }
+
+    inline bool write_chrome_json(char const* path) {
+        std::ofstream out(path);
+        write_chrome_json(out);
+        return static_cast<bool>(out);
+    }
+
+}  // namespace trace
+}  // namespace cav
+
+#endif /* CAV_SORT_TRACE */
+
+#endif /* CAV_INCLUDE_SORT_TRACE_HPP */
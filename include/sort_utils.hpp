@@ -5,59 +5,347 @@
 #define CAV_INCLUDE_SORT_UTILS_HPP
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
 
+#include "sort_config.hpp"
 #include "utils.hpp"
 
 namespace cav {
 /////////////////////////// KEYS CONVERSION ///////////////////////////
 
-static uint8_t to_uint(uint8_t k) noexcept {
-    return k;
-}
+/// @brief Customization point that maps a key type to an unsigned integer with the same ordering.
+/// Specialize it for user key types (fixed-point, half floats, ...) providing:
+///  - `using ukey_type = ...;` an unsigned integer type (or a big-endian std::array<uint8_t, N>);
+///  - `static ukey_type to_uint(T const& k) noexcept;` the order-preserving mapping;
+///  - optionally `static constexpr size_t bits = ...;` the number of meaningful low bits of
+///    ukey_type, so that the radix sorts can drop the bytes above them.
+template <typename T, typename = void>
+struct key_traits;
+
+#ifdef __SIZEOF_INT128__
+// __extension__: 128-bit integers are a GCC/Clang extension, -Wpedantic warns about the keyword
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+template <size_t Nb>
+struct uint_of_size;
+
+template <>
+struct uint_of_size<1> {
+    using type = uint8_t;
+};
+
+template <>
+struct uint_of_size<2> {
+    using type = uint16_t;
+};
+
+template <>
+struct uint_of_size<4> {
+    using type = uint32_t;
+};
+
+template <>
+struct uint_of_size<8> {
+    using type = uint64_t;
+};
+
+#ifdef __SIZEOF_INT128__
+template <>
+struct uint_of_size<16> {
+    using type = uint128_t;
+};
+#endif
 
-static uint16_t to_uint(uint16_t k) noexcept {
-    return k;
-}
+template <typename T>
+struct key_traits<T, CAV_REQUIRES(std::is_integral<T>::value && std::is_unsigned<T>::value)> {
+    using ukey_type = typename uint_of_size<sizeof(T)>::type;
 
-static uint32_t to_uint(uint32_t k) noexcept {
-    return k;
-}
+    static ukey_type to_uint(T k) noexcept {
+        return static_cast<ukey_type>(k);
+    }
+};
 
-static uint64_t to_uint(uint64_t k) noexcept {
-    return k;
-}
+template <typename T>
+struct key_traits<T, CAV_REQUIRES(std::is_integral<T>::value && std::is_signed<T>::value)> {
+    using ukey_type = typename uint_of_size<sizeof(T)>::type;
+
+    static ukey_type to_uint(T k) noexcept {
+        return static_cast<ukey_type>(static_cast<ukey_type>(k) +
+                                      (static_cast<ukey_type>(1U) << (8U * sizeof(T) - 1U)));
+    }
+};
+
+template <typename T>
+struct key_traits<T, CAV_REQUIRES(std::is_enum<T>::value)> {
+    using under_traits = key_traits<typename std::underlying_type<T>::type>;
+    using ukey_type    = typename under_traits::ukey_type;
+
+    static ukey_type to_uint(T k) noexcept {
+        return under_traits::to_uint(static_cast<typename std::underlying_type<T>::type>(k));
+    }
+};
+
+template <>
+struct key_traits<float> {
+    using ukey_type = uint32_t;
+
+    static uint32_t to_uint(float f) noexcept {
+        auto unsgn     = bit_cast<uint32_t>(f);
+        auto sign_mask = static_cast<uint32_t>(-static_cast<int32_t>(unsgn >> 31U));
+        return unsgn ^ (sign_mask | (1U << 31U));
+    }
+};
+
+template <>
+struct key_traits<double> {
+    using ukey_type = uint64_t;
+
+    static uint64_t to_uint(double d) noexcept {
+        auto unsgn     = bit_cast<uint64_t>(d);
+        auto sign_mask = static_cast<uint64_t>(-static_cast<int64_t>(unsgn >> 63U));
+        return unsgn ^ (sign_mask | (1ULL << 63U));
+    }
+};
+
+#ifdef __SIZEOF_INT128__
+template <>
+struct key_traits<uint128_t> {
+    using ukey_type = uint128_t;
+
+    static uint128_t to_uint(uint128_t k) noexcept {
+        return k;
+    }
+};
+
+template <>
+struct key_traits<int128_t> {
+    using ukey_type = uint128_t;
+
+    static uint128_t to_uint(int128_t k) noexcept {
+        return static_cast<uint128_t>(k) + (static_cast<uint128_t>(1U) << 127U);
+    }
+};
+#endif
+
+/// @brief Fixed-size byte strings (UUIDs, hashes, big-endian IDs) are already order-preserving.
+template <size_t N>
+struct key_traits<std::array<uint8_t, N>> {
+    using ukey_type = std::array<uint8_t, N>;
+
+    static ukey_type const& to_uint(ukey_type const& k) noexcept {
+        return k;
+    }
+};
 
-static uint8_t to_uint(int8_t k) noexcept {
-    return static_cast<uint8_t>(k) + static_cast<uint8_t>(1U << 7U);
+template <typename T>
+static auto to_uint(T const& k) noexcept -> decltype(key_traits<T>::to_uint(k)) {
+    return key_traits<T>::to_uint(k);
 }
 
-static uint16_t to_uint(int16_t k) noexcept {
-    return static_cast<uint16_t>(k) + static_cast<uint16_t>(1U << 15U);
+/// @brief Unsigned keys (as returned by to_uint) that can be split in bytes by the radix sorts.
+template <typename T>
+struct is_radix_ukey : std::is_unsigned<T> {};
+
+#ifdef __SIZEOF_INT128__
+template <>
+struct is_radix_ukey<uint128_t> : std::true_type {};
+#endif
+
+template <size_t N>
+struct is_radix_ukey<std::array<uint8_t, N>> : std::true_type {};
+
+/// @brief Key types whose operator< agrees with their key_traits. Comparison-based algorithms
+/// (networks, insertion sort, merges) use them as they are, other key types are compared through
+/// their to_uint mapping.
+template <typename T>
+struct has_native_order : std::is_arithmetic<T> {};
+
+#ifdef __SIZEOF_INT128__
+template <>
+struct has_native_order<int128_t> : std::true_type {};
+
+template <>
+struct has_native_order<uint128_t> : std::true_type {};
+#endif
+
+template <size_t N>
+struct has_native_order<std::array<uint8_t, N>> : std::true_type {};
+
+/// @brief Number of meaningful bits of the normalized key of T (key_traits<T>::bits if defined).
+template <typename T, typename = void>
+struct key_bits
+    : std::integral_constant<size_t, 8U * sizeof(typename key_traits<T>::ukey_type)> {};
+
+template <typename T>
+struct key_bits<T, decltype(static_cast<void>(key_traits<T>::bits))>
+    : std::integral_constant<size_t, key_traits<T>::bits> {};
+
+/// @brief Number of low bits of the normalized key of T that are not significant
+/// (key_traits<T>::low_bits if defined). The radix sorts skip the bytes entirely below them.
+template <typename T, typename = void>
+struct key_low_bits : std::integral_constant<size_t, 0> {};
+
+template <typename T>
+struct key_low_bits<T, decltype(static_cast<void>(key_traits<T>::low_bits))>
+    : std::integral_constant<size_t, key_traits<T>::low_bits> {};
+
+/////////////////////////// KEYS ORDERING ///////////////////////////
+
+/// @brief Key wrapper reversing the order of T. The complement is folded into the to_uint
+/// normalization, so every algorithm sorts descending keys at no extra cost.
+template <typename T>
+struct Desc {
+    T key;
+};
+
+template <typename T>
+Desc<T> desc(T key) noexcept {
+    return Desc<T>{key};
 }
 
-static uint32_t to_uint(int32_t k) noexcept {
-    return static_cast<uint32_t>(k) + (1U << 31U);
+/// @brief Key functor adaptor: sorts by `key` in descending order.
+template <typename K = IdentityFtor>
+struct DescFtor {
+    K key;
+
+    template <typename T>
+    auto operator()(T const& v) -> Desc<no_cvr<decltype(key(v))>> {
+        return {key(v)};
+    }
+};
+
+template <typename K = IdentityFtor>
+DescFtor<K> descending(K key = {}) noexcept {
+    return DescFtor<K>{key};
 }
 
-static uint64_t to_uint(int64_t k) noexcept {
-    return static_cast<uint64_t>(k) + (1ULL << 63U);
+template <typename U>
+static auto complement(U k) noexcept -> CAV_REQUIRES_T(U, !std::is_class<U>::value) {
+    return static_cast<U>(~k);
 }
 
-static uint32_t to_uint(float f) noexcept {
-    auto unsgn     = bit_cast<uint32_t>(f);
-    auto sign_mask = static_cast<uint32_t>(-static_cast<int32_t>(unsgn >> 31U));
-    return unsgn ^ (sign_mask | (1U << 31U));
+template <size_t N>
+static std::array<uint8_t, N> complement(std::array<uint8_t, N> k) noexcept {
+    for (uint8_t& b : k)
+        b = static_cast<uint8_t>(~b);
+    return k;
 }
 
-static uint64_t to_uint(double d) noexcept {
-    auto unsgn     = bit_cast<uint64_t>(d);
-    auto sign_mask = static_cast<uint64_t>(-static_cast<int64_t>(unsgn >> 63U));
-    return unsgn ^ (sign_mask | (1ULL << 63U));
+template <typename T>
+struct key_traits<Desc<T>> {
+    using ukey_type                  = typename key_traits<T>::ukey_type;
+    static constexpr size_t bits     = key_bits<T>::value;
+    static constexpr size_t low_bits = key_low_bits<T>::value;  // complemented, still constant
+
+    static ukey_type to_uint(Desc<T> const& d) noexcept {
+        return cav::complement(cav::to_uint(d.key));
+    }
+};
+
+/// @brief Key wrapper stating that only the bits [Lo, Hi) of the normalized key of T are
+/// significant, e.g., 40-bit timestamps packed in a uint64_t. The other bits are masked out, and
+/// the radix sorts drop the bytes outside the range at compile time (fewer counters and passes).
+template <typename T, size_t Lo, size_t Hi>
+struct BitRange {
+    T key;
+};
+
+/// @brief Key functor adaptor: sorts by the bits [Lo, Hi) of the normalized `key`.
+template <size_t Lo, size_t Hi, typename K = IdentityFtor>
+struct BitRangeFtor {
+    K key;
+
+    template <typename T>
+    auto operator()(T const& v) -> BitRange<no_cvr<decltype(key(v))>, Lo, Hi> {
+        return {key(v)};
+    }
+};
+
+template <size_t Lo, size_t Hi, typename K = IdentityFtor>
+BitRangeFtor<Lo, Hi, K> bit_range(K key = {}) noexcept {
+    return BitRangeFtor<Lo, Hi, K>{key};
 }
 
+template <typename T, size_t Lo, size_t Hi>
+struct key_traits<BitRange<T, Lo, Hi>> {
+    using ukey_type                  = typename key_traits<T>::ukey_type;
+    static constexpr size_t bits     = Hi;
+    static constexpr size_t low_bits = Lo;
+    static_assert(Lo < Hi && Hi <= 8U * sizeof(ukey_type), "Invalid bit range");
+    static_assert(!std::is_class<ukey_type>::value, "Bit ranges require integer keys");
+
+    static ukey_type to_uint(BitRange<T, Lo, Hi> const& r) noexcept {
+        constexpr auto ones = static_cast<ukey_type>(~ukey_type{});
+        constexpr auto mask = static_cast<ukey_type>(
+            static_cast<ukey_type>(ones >> (8U * sizeof(ukey_type) - Hi)) & (ones << Lo));
+        return static_cast<ukey_type>(cav::to_uint(r.key) & mask);
+    }
+};
+
+/// @brief Composite keys: the fields of a tuple are packed, most significant first, into a single
+/// unsigned integer, each one taking the bytes it needs. Wrap a field in Desc to reverse it alone,
+/// e.g., `[](Rec const& r) { return std::make_tuple(desc(r.score), r.id); }`.
+template <typename... Ts>
+struct tuple_key_bytes : std::integral_constant<size_t, 0> {};
+
+template <typename T, typename... Ts>
+struct tuple_key_bytes<T, Ts...>
+    : std::integral_constant<size_t,
+                             (key_bits<no_cvr<T>>::value + 7U) / 8U +
+                                 tuple_key_bytes<Ts...>::value> {};
+
+template <typename U, size_t I, size_t N>
+struct TupleKeyPacker {
+    template <typename Tup>
+    static U pack(Tup const& tup, U acc) noexcept {
+        using field_t               = no_cvr<typename std::tuple_element<I, Tup>::type>;
+        using field_ukey_t          = typename key_traits<field_t>::ukey_type;
+        constexpr size_t field_bits = 8U * ((key_bits<field_t>::value + 7U) / 8U);
+        static_assert(!std::is_class<field_ukey_t>::value, "Composite key fields must be integers");
+
+        // Bits above key_bits (e.g., complemented by Desc) must not spill into the previous field
+        auto mask = static_cast<field_ukey_t>(
+            ((field_ukey_t{1} << (field_bits / 2U)) << (field_bits - field_bits / 2U)) - 1U);
+
+        acc = (acc << (field_bits / 2U)) << (field_bits - field_bits / 2U);
+        acc |= static_cast<U>(cav::to_uint(std::get<I>(tup)) & mask);
+        return TupleKeyPacker<U, I + 1, N>::pack(tup, acc);
+    }
+};
+
+template <typename U, size_t N>
+struct TupleKeyPacker<U, N, N> {
+    template <typename Tup>
+    static U pack(Tup const& /*tup*/, U acc) noexcept {
+        return acc;
+    }
+};
+
+template <typename... Ts>
+struct key_traits<std::tuple<Ts...>> {
+    static constexpr size_t n_bytes = tuple_key_bytes<Ts...>::value;
+    static_assert(n_bytes <= 16U, "Composite key too wide");
+
+    using ukey_type = typename uint_of_size<(n_bytes <= 1U   ? 1U
+                                             : n_bytes <= 2U ? 2U
+                                             : n_bytes <= 4U ? 4U
+                                             : n_bytes <= 8U ? 8U
+                                                             : 16U)>::type;
+    static constexpr size_t bits = 8U * n_bytes;
+
+    static ukey_type to_uint(std::tuple<Ts...> const& tup) noexcept {
+        return TupleKeyPacker<ukey_type, 0, sizeof...(Ts)>::pack(tup, ukey_type{});
+    }
+};
+
 namespace sort {
     ///////// SHORTHAND TEMPLATE ALIASES FOR SORTED TYPES METADATA //////////
     template <typename C, typename K>
@@ -65,7 +353,12 @@ namespace sort {
         using value_type = container_value_type_t<C>;
         using key_type   = no_cvr<decltype(std::declval<K>()(std::declval<value_type>()))>;
         using ukey_type  = no_cvr<decltype(to_uint(std::declval<key_type>()))>;
-        static_assert(sizeof(key_type) == sizeof(ukey_type), "Key and ukey size mismatch");
+
+        // Bytes of ukey_type the radix sorts need to look at: [lo_byte, n_bytes)
+        static constexpr size_t n_bytes = (key_bits<key_type>::value + 7U) / 8U;
+        static constexpr size_t lo_byte = key_low_bits<key_type>::value / 8U;
+        static_assert(n_bytes <= sizeof(ukey_type), "Key bits exceed the ukey size");
+        static_assert(lo_byte < n_bytes, "No significant key bytes");
     };
 
     template <typename C>
@@ -77,6 +370,27 @@ namespace sort {
     template <typename C, typename K>
     using ukey_t = typename sort_data<C, K>::ukey_type;
 
+    /// @brief Strips the ordering wrappers (Desc, BitRange) from a key type.
+    template <typename T>
+    struct unwrap_key {
+        using type = T;
+    };
+
+    template <typename T>
+    struct unwrap_key<Desc<T>> : unwrap_key<T> {};
+
+    template <typename T, size_t Lo, size_t Hi>
+    struct unwrap_key<BitRange<T, Lo, Hi>> : unwrap_key<T> {};
+
+    /// @brief Best effort to detect containers of native types using themselves as a key (in
+    /// any order).
+    template <typename C, typename K>
+    struct is_self_keyed
+        : std::integral_constant<
+              bool,
+              std::is_empty<K>::value &&
+                  std::is_same<value_t<C>, typename unwrap_key<key_t<C, K>>::type>::value> {};
+
     template <typename K>
     struct CompWrap {
         K key;
@@ -92,8 +406,127 @@ namespace sort {
         return CompWrap<K>{key};
     }
 
+    template <typename C, typename K>
+    constexpr size_t n_bytes() {
+        return sort_data<C, K>::n_bytes;
+    }
+
+    template <typename C, typename K>
+    constexpr size_t lo_byte() {
+        return sort_data<C, K>::lo_byte;
+    }
+
+    /// @brief Key functor returning the normalized key, to compare keys without native order.
+    template <typename K>
+    struct UKeyFtor {
+        K key;
+
+        template <typename T>
+        auto operator()(T const& v) -> no_cvr<decltype(to_uint(key(v)))> {
+            return to_uint(key(v));
+        }
+    };
+
+    /// @brief True for key types ordered only by their key_traits (no usable native order).
+    template <typename T, typename = void>
+    struct needs_ukey_cmp : std::false_type {};
+
+    template <typename T>
+    struct needs_ukey_cmp<T, decltype(static_cast<void>(to_uint(std::declval<T>())))>
+        : std::integral_constant<bool, !has_native_order<T>::value> {};
+
+    template <typename C, typename K>
+    using cmp_key_t = no_cvr<decltype(std::declval<K&>()(std::declval<value_t<C>&>()))>;
+
+    template <typename C, typename K>
+    auto make_cmp_key(K key) noexcept
+        -> CAV_REQUIRES_T(K, !needs_ukey_cmp<cmp_key_t<C, K>>::value) {
+        return key;
+    }
+
+    template <typename C, typename K>
+    auto make_cmp_key(K key) noexcept
+        -> CAV_REQUIRES_T(UKeyFtor<K>, needs_ukey_cmp<cmp_key_t<C, K>>::value) {
+        return UKeyFtor<K>{key};
+    }
+
+    /// @brief True for key functors with a `prefetch(value)` member, which starts loading the key
+    /// of a value that is going to be needed soon (see IndirectKey).
+    template <typename K, typename V, typename = void>
+    struct has_prefetch : std::false_type {};
+
+    template <typename K, typename V>
+    struct has_prefetch<K, V, decltype(std::declval<K&>().prefetch(std::declval<V const&>()))>
+        : std::true_type {};
+
+    /// @brief Prefetches the key of the element CAV_KEY_PREFETCH_DIST places after the i-th, so
+    /// that the key loads of a pass overlap instead of stalling one by one.
+    template <typename C, typename K>
+    auto prefetch_ahead(C const& cont, K& key, size_t i)
+        -> CAV_REQUIRES(has_prefetch<K, value_t<C>>::value) {
+        if (i + CAV_KEY_PREFETCH_DIST < cav::size(cont))
+            key.prefetch(std::begin(cont)[i + CAV_KEY_PREFETCH_DIST]);
+    }
+
+    template <typename C, typename K>
+    auto prefetch_ahead(C const& /*cont*/, K& /*key*/, size_t /*i*/)
+        -> CAV_REQUIRES(!has_prefetch<K, value_t<C>>::value) {
+    }
+
+    /// @brief Prefetches the keys of all the elements, before a small sort that reads them in
+    /// data dependent order (insertion sort).
+    template <typename C, typename K>
+    auto prefetch_all(C const& cont, K& key) -> CAV_REQUIRES(has_prefetch<K, value_t<C>>::value) {
+        for (auto const& elem : cont)
+            key.prefetch(elem);
+    }
+
+    template <typename C, typename K>
+    auto prefetch_all(C const& /*cont*/, K& /*key*/)
+        -> CAV_REQUIRES(!has_prefetch<K, value_t<C>>::value) {
+    }
+
 }  // namespace sort
 
+/// @brief Prefetches (for reading) the cache lines of the `bytes` bytes starting at `ptr`.
+inline void prefetch_bytes(void const* ptr, size_t bytes) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    auto addr = reinterpret_cast<uintptr_t>(ptr);
+    for (uintptr_t line = addr & ~uintptr_t{63}; line < addr + bytes; line += 64)
+        __builtin_prefetch(reinterpret_cast<void const*>(line));
+#else
+    static_cast<void>(ptr);
+    static_cast<void>(bytes);
+#endif
+}
+
+/// @brief Key of indexes (or other offsets) into a random access range, `key(i) = proj(base[i])`:
+///
+///     sorter.sort(idxs, cav::indirect_key(scores.data()));
+///
+/// It sorts like the equivalent lambda, but the radix passes can prefetch `base[i]` a few elements
+/// ahead, which pays off when the keys do not fit in the last level cache.
+template <typename It, typename P = IdentityFtor>
+struct IndirectKey {
+    It base;
+    P  proj;
+
+    template <typename I>
+    auto operator()(I i) const -> no_cvr<decltype(std::declval<P const&>()(base[i]))> {
+        return proj(base[i]);
+    }
+
+    template <typename I>
+    void prefetch(I i) const noexcept {
+        prefetch_bytes(std::addressof(base[i]), 1);
+    }
+};
+
+template <typename It, typename P = IdentityFtor>
+IndirectKey<It, P> indirect_key(It base, P proj = {}) {
+    return IndirectKey<It, P>{base, proj};
+}
+
 template <size_t N, typename T>
 static uint8_t nth_byte(T k) noexcept {
     static_assert(N < sizeof(k), "Nth byte out of range");
@@ -101,11 +534,24 @@ static uint8_t nth_byte(T k) noexcept {
 }
 
 template <typename T>
-static uint8_t nth_byte(T k, uint8_t n) noexcept {
+static uint8_t nth_byte(T k, size_t n) noexcept {
     assert(n < sizeof(k));
     return static_cast<uint8_t>(k >> 8U * n);
 }
 
+/// @brief Byte arrays are big-endian: the 0th byte is the least significant one (the last).
+template <size_t N, size_t Nk>
+static uint8_t nth_byte(std::array<uint8_t, Nk> const& k) noexcept {
+    static_assert(N < Nk, "Nth byte out of range");
+    return k[Nk - 1U - N];
+}
+
+template <size_t Nk>
+static uint8_t nth_byte(std::array<uint8_t, Nk> const& k, size_t n) noexcept {
+    assert(n < Nk);
+    return k[Nk - 1U - n];
+}
+
 /// @brief Moves src to dest. Assumes that dest refers to uninitialized memory.
 template <typename D, typename S>
 static auto move_uninit(D& dest, S& src) -> CAV_REQUIRES(!std::is_trivially_copyable<D>::value) {
@@ -140,10 +586,11 @@ static auto move_uninit_span(D&& dest, S&& src)
 
 /////////////////////////////// INSERTION SORT ///////////////////////////////////////
 template <typename C, typename K = IdentityFtor>
-static void insertion_sort(C& cont, K key = {}) {
+static void insertion_sort(C& cont, K key_ftor = {}) {
     if (cav::size(cont) < 2)
         return;
 
+    auto key  = sort::make_cmp_key<C>(key_ftor);
     auto cbeg = std::begin(cont);
     for (auto it = cbeg + 1; it != std::end(cont); ++it) {
         auto ikey = key(*it);
@@ -95,7 +95,7 @@
 #define CAV_INCLUDE_UTILS_SORTING_NETWORKS_HPP
 
 #ifndef CAV_MAX_NET_SIZE
-#define CAV_MAX_NET_SIZE 32
+#define CAV_MAX_NET_SIZE 32U
 #endif
 
 #include <cstdint>
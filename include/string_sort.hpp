@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_STRING_SORT_HPP
+#define CAV_INCLUDE_STRING_SORT_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "Span.hpp"
+#include "radix_sort.hpp"
+#include "sort_utils.hpp"
+#include "utils.hpp"
+
+namespace cav {
+
+/// @brief Working entry of the string radix sort: a pointer to the sorted element next to its key
+/// length and a cached big-endian copy of 8 key bytes. Most digits are read from the cached
+/// prefix, the string is dereferenced only once every 8 levels (or to break ties).
+template <typename T>
+struct StrEntry {
+    uint64_t pfx;  // key bytes [depth & ~7, (depth & ~7) + 8), zero padded
+    size_t   len;  // key length
+    T*       ptr;  // element
+};
+
+////////////////////////////////////////////////////////////////////////////
+////////////////////////// STRING MSD RADIX SORT ///////////////////////////
+////////////////////////////////////////////////////////////////////////////
+namespace {
+    /// @brief Loads the 8 key bytes starting at `pos` as a big-endian integer (zero padded).
+    template <typename S>
+    uint64_t load_str_prefix(S const& str, size_t pos) {
+        size_t        len      = cav::size(str);
+        unsigned char bytes[8] = {};
+        if (pos < len)
+            std::memcpy(bytes, str.data() + pos, min(size_t{8}, len - pos));
+
+        uint64_t pfx = 0;
+        for (unsigned char c : bytes)
+            pfx = (pfx << 8U) | c;
+        return pfx;
+    }
+
+    /// @brief Digit of the entry at `depth`: 0 marks the end-of-string, 1 + byte value otherwise.
+    template <typename T>
+    uint16_t str_digit(StrEntry<T> const& e, size_t depth) {
+        if (depth >= e.len)
+            return 0;
+        return 1U + static_cast<uint8_t>(e.pfx >> (56U - 8U * (depth & 7U)));
+    }
+
+    /// @brief Compares two entries that share their first `depth` key bytes.
+    template <typename T, typename K>
+    bool str_less(StrEntry<T> const& e1, StrEntry<T> const& e2, size_t depth, K& key) {
+        if (e1.pfx != e2.pfx)
+            return e1.pfx < e2.pfx;
+
+        size_t next = (depth & ~size_t{7}) + 8;
+        if (e1.len <= next || e2.len <= next)
+            return e1.len < e2.len;
+
+        auto const& s1     = key(*e1.ptr);
+        auto const& s2     = key(*e2.ptr);
+        size_t      common = min(e1.len, e2.len) - next;
+        int         cmp    = std::memcmp(s1.data() + next, s2.data() + next, common);
+        return cmp != 0 ? cmp < 0 : e1.len < e2.len;
+    }
+
+    template <typename C, typename K>
+    void str_insertion_sort(C& entries, K& key, size_t depth) {
+        auto beg = std::begin(entries);
+        for (auto it = beg + 1; it < std::end(entries); ++it) {
+            auto val  = *it;
+            auto next = it;
+            for (; next != beg && str_less(val, *(next - 1), depth, key); --next)
+                *next = *(next - 1);
+            *next = val;
+        }
+    }
+
+    template <typename SzT, typename C1, typename C2, typename K>
+    void str_radix_msd(C1& entries, C2& buff, K& key, size_t depth) {
+        using entry_t = sort::value_t<C1>;
+
+        for (;;) {
+            if (cav::size(entries) < 32U)
+                return str_insertion_sort(entries, key, depth);
+
+            // Skip the bytes shared by the whole bucket (common prefixes) without moving entries
+            uint16_t first = str_digit(entries[0], depth);
+            if (all(entries, [&](entry_t const& e) { return str_digit(e, depth) == first; })) {
+                if (first == 0)
+                    return;  // all keys ended, nothing left to sort
+                if ((++depth & 7U) == 0)
+                    for (auto& e : entries)
+                        e.pfx = load_str_prefix(key(*e.ptr), depth);
+                continue;
+            }
+            break;
+        }
+
+        SzT  counters[257] = {};
+        auto digit         = [depth](entry_t const& e) { return str_digit(e, depth); };
+        auto srng          = distribute_msd(entries, buff, digit, counters);
+        move_uninit_span(entries, buff);
+
+        // Bucket 0 holds the keys that end at `depth`: they are equal and already in place
+        ++depth;
+        SzT sub_beg = srng.beg == 0 ? counters[0] : counters[srng.beg - 1];
+        for (SzT s = max(srng.beg, 1U); s < srng.end; sub_beg = counters[s++]) {
+            if (counters[s] - sub_beg < 2)
+                continue;
+
+            auto sub_entries = make_span(entries, sub_beg, counters[s]);
+            auto sub_buff    = make_span(buff, sub_beg, counters[s]);
+            if ((depth & 7U) == 0)
+                for (auto& e : sub_entries)
+                    e.pfx = load_str_prefix(key(*e.ptr), depth);
+            str_radix_msd<SzT>(sub_entries, sub_buff, key, depth);
+        }
+    }
+
+    /// @brief Moves each element of `cont` in the position of its entry, following the
+    /// permutation cycles (one move per element, plus one temporary per cycle).
+    template <typename SzT, typename C1, typename C2>
+    void permute_by_entries(C1& cont, C2& entries) {
+        auto* base = std::addressof(cont[0]);
+        for (SzT i = 0; i < cav::size(entries); ++i) {
+            if (entries[i].ptr == base + i)
+                continue;
+
+            auto tmp = std::move(base[i]);
+            SzT  j   = i;
+            for (;;) {
+                auto k         = static_cast<SzT>(entries[j].ptr - base);
+                entries[j].ptr = base + j;
+                if (k == i) {
+                    base[j] = std::move(tmp);
+                    break;
+                }
+                base[j] = std::move(base[k]);
+                j       = k;
+            }
+        }
+    }
+}  // namespace
+
+/// @brief MSD radix sort for variable-length byte-string keys (std::string or any type exposing
+/// data() and size()). The key should return a reference or a view: it is invoked once per
+/// element, plus once every 8 levels of depth. `cont` must be contiguous and `buff` must hold at
+/// least 2 * size(cont) StrEntry.
+template <typename SzT, typename C1, typename C2, typename K = IdentityFtor>
+static void radix_sort_str(C1& cont, C2& buff, K key = {}) {
+    using entry_t = StrEntry<sort::value_t<C1>>;
+    static_assert(std::is_same<sort::value_t<C2>, entry_t>::value, "Buffer must hold StrEntry");
+    assert(2 * cav::size(cont) <= cav::size(buff));
+
+    SzT csize = cav::size(cont);
+    if (csize < 2)
+        return;
+
+    auto entries = make_span(std::begin(buff), csize);
+    auto ebuff   = make_span(std::begin(buff) + csize, csize);
+    for (SzT i = 0; i < csize; ++i) {
+        auto const& str = key(cont[i]);
+        entries[i]      = entry_t{load_str_prefix(str, 0), cav::size(str), std::addressof(cont[i])};
+    }
+
+    str_radix_msd<SzT>(entries, ebuff, key, 0);
+    permute_by_entries<SzT>(cont, entries);
+}
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_STRING_SORT_HPP */
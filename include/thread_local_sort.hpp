@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_THREAD_LOCAL_SORT_HPP
+#define CAV_INCLUDE_THREAD_LOCAL_SORT_HPP
+
+/// Free functions backed by a lazily created Sorter per thread (and per size type), to reuse the
+/// working buffer between calls without carrying a Sorter around:
+///
+///     cav::tl::sort(values);
+///     cav::tl::nth_element(values, values.size() / 2, [](Rec const& r) { return r.score; });
+///     auto order = cav::tl::argsort(values);
+///
+/// Each thread has its own Sorter, so they can be called from many threads at once. A buffer
+/// grown above CAV_TL_MAX_CACHED_BYTES is released at the end of the call, so that a thread does
+/// not pin the memory of an occasional large sort. Nested calls (e.g., from a key functor) use a
+/// temporary Sorter instead of the cached one.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sort.hpp"
+#include "sort_utils.hpp"
+#include "utils.hpp"
+
+/// Largest working buffer each thread keeps between calls, in bytes.
+#ifndef CAV_TL_MAX_CACHED_BYTES
+#define CAV_TL_MAX_CACHED_BYTES (size_t{64} << 20U)
+#endif
+
+namespace cav {
+namespace tl {
+
+    // The helpers have external linkage (no anonymous namespace): one cached Sorter per thread in
+    // the whole program, not one per translation unit.
+    template <typename SzT>
+    struct ThreadSorter {
+        Sorter<SzT> sorter;
+        bool        busy = false;
+    };
+
+    template <typename SzT>
+    ThreadSorter<SzT>& thread_sorter() {
+        static thread_local ThreadSorter<SzT> cached;
+        return cached;
+    }
+
+    /// @brief Marks the cached Sorter as in use and trims its buffer when done (also on throw).
+    template <typename SzT>
+    struct SorterLease {
+        ThreadSorter<SzT>& cached;
+
+        explicit SorterLease(ThreadSorter<SzT>& ts) noexcept
+            : cached(ts) {
+            cached.busy = true;
+        }
+
+        SorterLease(SorterLease const&)            = delete;
+        SorterLease& operator=(SorterLease const&) = delete;
+
+        ~SorterLease() {
+            if (cached.sorter.capacity() > CAV_TL_MAX_CACHED_BYTES)
+                cached.sorter.shrink_to_fit();
+            cached.busy = false;
+        }
+    };
+
+    template <typename SzT, typename F>
+    void with_sorter(F&& fn) {
+        ThreadSorter<SzT>& cached = thread_sorter<SzT>();
+        if (cached.busy) {
+            auto local = Sorter<SzT>();
+            return fn(local);
+        }
+        SorterLease<SzT> lease(cached);
+        fn(cached.sorter);
+    }
+
+    /// @brief The Sorter cached by the calling thread, e.g., to reserve() its buffer in advance.
+    template <typename SzT = uint32_t>
+    Sorter<SzT>& sorter() {
+        return thread_sorter<SzT>().sorter;
+    }
+
+    /// @brief Releases the buffer cached by the calling thread.
+    template <typename SzT = uint32_t>
+    void release() {
+        thread_sorter<SzT>().sorter.shrink_to_fit();
+    }
+
+    /// @brief Sorter::sort with the Sorter of the calling thread. SzT must hold the container size.
+    template <typename SzT = uint32_t, typename C, typename K = IdentityFtor>
+    void sort(C& container, K key = {}) {
+        with_sorter<SzT>([&](Sorter<SzT>& s) { s.sort(container, key); });
+    }
+
+    /// @brief Sorter::nth_element with the Sorter of the calling thread.
+    template <typename SzT = uint32_t, typename C, typename K = IdentityFtor>
+    void nth_element(C& container, size_t nth, K key = {}) {
+        with_sorter<SzT>(
+            [&](Sorter<SzT>& s) { s.nth_element(container, static_cast<SzT>(nth), key); });
+    }
+
+    /// @brief Sorter::sort_by_key with the Sorter of the calling thread.
+    template <typename SzT = uint32_t, typename KC, typename... PCs>
+    void sort_by_key(KC& keys, PCs&... payloads) {
+        with_sorter<SzT>([&](Sorter<SzT>& s) { s.sort_by_key(keys, payloads...); });
+    }
+
+    /// @brief Indexes of the elements of `container` in the order of their keys (ties in any
+    /// order), sorted through an IndirectKey by the Sorter of the calling thread.
+    template <typename IdxT = uint32_t, typename C, typename K = IdentityFtor>
+    std::vector<IdxT> argsort(C const& container, K key = {}) {
+        auto idxs = std::vector<IdxT>(cav::size(container));
+        for (size_t i = 0; i < idxs.size(); ++i)
+            idxs[i] = static_cast<IdxT>(i);
+        auto ind = indirect_key(std::begin(container), key);
+        with_sorter<IdxT>([&](Sorter<IdxT>& s) { s.sort(idxs, ind); });
+        return idxs;
+    }
+
+}  // namespace tl
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_THREAD_LOCAL_SORT_HPP */
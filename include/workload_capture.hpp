@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_INCLUDE_WORKLOAD_CAPTURE_HPP
+#define CAV_INCLUDE_WORKLOAD_CAPTURE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "sort_stats.hpp"
+#include "sort_utils.hpp"
+#include "utils.hpp"
+
+namespace cav {
+
+/// @brief What a WorkloadCapture learned about the calls with the same key kind, key size and
+/// value size: how many they were, the sizes of the sampled ones and the histograms of each byte
+/// of their keys (mapped by to_uint, i.e., the digits the LSD radix sort counts).
+struct WorkloadShape {
+    using ByteHist = std::array<uint64_t, 256>;
+
+    char                  key_kind = 'x';  // 'u'nsigned, 'i' signed, 'f'loating point, 'x' other
+    uint32_t              key_size = 0;    // sizeof of the key
+    uint32_t              val_size = 0;    // sizeof of the sorted values
+    uint64_t              calls    = 0;    // all of them, sampled or not
+    uint64_t              sampled  = 0;
+    std::vector<uint64_t> sizes;      // reservoir of the sizes of the sampled calls
+    std::vector<ByteHist> byte_hist;  // byte_hist[b][d]: sampled keys whose b-th byte is d
+};
+
+/// @brief Stats policy of Sorter recording a compact summary of the sort() calls it sees, so that
+/// the replay benchmark (src/replay.cpp) can generate inputs like the real ones:
+///
+///     auto sorter = cav::Sorter<uint32_t, std::allocator<char>, cav::WorkloadCapture>();
+///     ...  // the application sorts as usual
+///     sorter.stats().save("workload.txt");
+///
+/// One call every 2^sample_log2 (at random, 0 samples them all) is sampled: its size goes into a
+/// reservoir of max_sizes sizes and at most max_hist_elems of its keys, evenly spaced, into the
+/// byte histograms. The other calls only cost a shape lookup and a random number, the other hooks
+/// are the empty ones of NoSortStats.
+struct WorkloadCapture : NoSortStats {
+    static constexpr uint8_t default_sample_log2 = 6;
+    static constexpr size_t  max_sizes           = 1024;
+    static constexpr size_t  max_hist_elems      = 4096;
+
+    std::vector<WorkloadShape> shapes;
+    uint8_t                    sample_log2 = default_sample_log2;
+
+    template <typename C, typename K>
+    void observe(C const& container, K key) {
+        using key_type = sort::key_t<C, K>;
+        using plain_t  = typename sort::unwrap_key<key_type>::type;
+        char kind      = !std::is_same<key_type, plain_t>::value ? 'x'
+                       : std::is_floating_point<plain_t>::value  ? 'f'
+                       : !std::is_integral<plain_t>::value       ? 'x'
+                       : std::is_signed<plain_t>::value          ? 'i'
+                                                                 : 'u';
+        WorkloadShape& shape = _shape_of(kind, sizeof(key_type), sizeof(sort::value_t<C>));
+        ++shape.calls;
+        if ((sample_log2 > 0 && (_next_rand() >> (32U - sample_log2)) != 0) ||
+            cav::size(container) == 0)
+            return;
+
+        size_t n = cav::size(container);
+        ++shape.sampled;
+        if (shape.sizes.size() < max_sizes)
+            shape.sizes.push_back(n);
+        else if (_next_rand() % shape.sampled < max_sizes)  // reservoir sampling
+            shape.sizes[_next_rand() % max_sizes] = n;
+
+        constexpr size_t n_bytes = sort::n_bytes<C, K>();
+        shape.byte_hist.resize(n_bytes, WorkloadShape::ByteHist{});
+        size_t stride = max(n / max_hist_elems, size_t{1});
+        auto   beg    = std::begin(container);
+        for (size_t i = 0; i < n; i += stride) {
+            auto ukey = to_uint(key(beg[i]));
+            for (size_t b = 0; b < n_bytes; ++b)
+                ++shape.byte_hist[b][nth_byte(ukey, b)];
+        }
+    }
+
+    void reset() {
+        shapes.clear();
+    }
+
+    /// @brief Writes the shapes as text, one `shape` line followed by its `sizes` and `hist` lines.
+    void save(std::ostream& out) const {
+        out << "cav-workload 1\n";
+        for (WorkloadShape const& shape : shapes) {
+            out << "shape " << shape.key_kind << ' ' << shape.key_size << ' ' << shape.val_size
+                << ' ' << shape.calls << ' ' << shape.sampled << ' ' << shape.byte_hist.size()
+                << "\nsizes " << shape.sizes.size();
+            for (uint64_t sz : shape.sizes)
+                out << ' ' << sz;
+            for (WorkloadShape::ByteHist const& hist : shape.byte_hist) {
+                out << "\nhist";
+                for (uint64_t count : hist)
+                    out << ' ' << count;
+            }
+            out << '\n';
+        }
+    }
+
+    bool save(char const* path) const {
+        std::ofstream out(path);
+        save(out);
+        return static_cast<bool>(out);
+    }
+
+    /// @brief Reads the shapes written by save(), returns false if the input is malformed. Any key
+    /// size save() writes is accepted: the sizes and histograms are read one by one rather than
+    /// trusting the counts, and sizes must be positive (the replay draws calls from them).
+    bool load(std::istream& in) {
+        auto magic   = std::string();
+        int  version = 0;
+        if (!(in >> magic >> version) || magic != "cav-workload" || version != 1)
+            return false;
+        shapes.clear();
+        auto   tag     = std::string();
+        auto   shape   = WorkloadShape();
+        size_t n_hist  = 0;
+        size_t n_sizes = 0;
+        while (in >> tag) {
+            if (tag != "shape" ||
+                !(in >> shape.key_kind >> shape.key_size >> shape.val_size >> shape.calls >>
+                  shape.sampled >> n_hist >> tag >> n_sizes) ||
+                tag != "sizes")
+                return false;
+            shape.sizes.clear();
+            for (size_t i = 0; i < n_sizes; ++i) {
+                uint64_t sz = 0;
+                if (!(in >> sz) || sz == 0)
+                    return false;
+                shape.sizes.push_back(sz);
+            }
+            shape.byte_hist.clear();
+            for (size_t b = 0; b < n_hist; ++b) {
+                if (!(in >> tag) || tag != "hist")
+                    return false;
+                shape.byte_hist.emplace_back();
+                for (uint64_t& count : shape.byte_hist.back())
+                    in >> count;
+            }
+            if (!in)
+                return false;
+            shapes.push_back(shape);
+        }
+        return in.eof();
+    }
+
+    bool load(char const* path) {
+        std::ifstream in(path);
+        return in && load(in);
+    }
+
+private:
+    WorkloadShape& _shape_of(char kind, uint32_t key_size, uint32_t val_size) {
+        for (WorkloadShape& shape : shapes)
+            if (shape.key_kind == kind && shape.key_size == key_size && shape.val_size == val_size)
+                return shape;
+        shapes.emplace_back();
+        shapes.back().key_kind = kind;
+        shapes.back().key_size = key_size;
+        shapes.back().val_size = val_size;
+        return shapes.back();
+    }
+
+    uint32_t _next_rand() {  // xorshift32
+        rng_state ^= rng_state << 13U;
+        rng_state ^= rng_state >> 17U;
+        rng_state ^= rng_state << 5U;
+        return rng_state;
+    }
+
+    uint32_t rng_state = 0x9E3779B9U;
+};
+
+}  // namespace cav
+
+#endif /* CAV_INCLUDE_WORKLOAD_CAPTURE_HPP */
@@ -0,0 +1,288 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Measures on the host the crossover points used by Sorter to pick an algorithm and writes them
+// in a header that can be passed back through CAV_TUNED_CONFIG. Each algorithm is timed directly,
+// so the thresholds currently in use do not affect the measurements.
+#undef CAV_TUNED_CONFIG
+
+#include <fmt/core.h>
+#include <fmt/os.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Span.hpp"
+#include "limits.hpp"
+#include "sort.hpp"
+
+namespace {
+
+/// Struct-like value of Sz bytes sorted by its first field.
+template <typename T, size_t Sz, bool Pad = (Sz > sizeof(T))>
+struct Record {
+    T    key;
+    char pad[Sz - sizeof(T)];
+};
+
+template <typename T, size_t Sz>
+struct Record<T, Sz, false> {
+    T key;
+};
+
+struct RecordKey {
+    template <typename R>
+    auto operator()(R const& r) const -> decltype(r.key) {
+        return r.key;
+    }
+};
+
+constexpr size_t min_tot_elems = 1U << 16U;
+constexpr int    n_reps        = 3;
+
+template <typename T>
+T rand_val() {
+    double rnd = static_cast<double>(rand()) / static_cast<double>(RAND_MAX);
+    double max = std::sqrt(static_cast<double>(cav::limits<T>::max()));
+    return static_cast<T>((2.0 * rnd - 1.0) * max);
+}
+
+/// @brief Sorts consecutive chunks of `n` elements with `algo`, returns the best ns per element.
+template <typename T, typename F>
+double ns_per_elem(std::vector<T> const& origin, size_t n, F algo) {
+    size_t tot  = cav::max(n, min_tot_elems) / n * n;
+    auto   seq  = std::vector<T>(origin.begin(), origin.begin() + tot);
+    double best = cav::limits<double>::max();
+    for (int r = 0; r < n_reps; ++r) {
+        std::copy(origin.begin(), origin.begin() + tot, seq.begin());
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t o = 0; o < tot; o += n) {
+            auto chunk = cav::make_span(seq.data() + o, n);
+            algo(chunk);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        best    = cav::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / tot);
+    }
+    return best;
+}
+
+/// @brief Smallest measured size from which `challenger` is always faster than `incumbent`.
+/// Returns 0 if the challenger does not win at the largest size (not measured).
+template <typename V, typename F1, typename F2>
+size_t crossover(char const*           name,
+                 std::vector<V> const& origin,
+                 size_t                min_n,
+                 size_t                max_n,
+                 F1                    incumbent,
+                 F2                    challenger) {
+    auto sizes = std::vector<size_t>();
+    auto wins  = std::vector<bool>();
+    fmt::print("{:10}", name);
+    for (size_t n = min_n; n <= max_n; n *= 2) {
+        double t_inc = ns_per_elem(origin, n, incumbent);
+        double t_cha = ns_per_elem(origin, n, challenger);
+        fmt::print(" {:>6}:{:4.0f}/{:<4.0f}", n, t_inc, t_cha);
+        std::fflush(stdout);
+        sizes.push_back(n);
+        wins.push_back(t_cha < t_inc);
+    }
+
+    size_t i = sizes.size();
+    while (i > 0 && wins[i - 1])
+        --i;
+    size_t cross = i < sizes.size() ? sizes[i] : 0;
+    if (cross == 0)
+        fmt::print(" -> not measured (above {})\n", max_n);
+    else
+        fmt::print(" -> {}\n", cross);
+    return cross;
+}
+
+size_t median(std::vector<size_t> vals) {
+    std::sort(vals.begin(), vals.end());
+    return vals[vals.size() / 2];
+}
+
+template <typename V, typename T = V>
+std::vector<V> make_values(size_t n) {
+    auto vals = std::vector<V>(n);
+    for (auto& v : vals)
+        v.key = rand_val<T>();
+    return vals;
+}
+
+template <typename T>
+std::vector<T> make_natives(size_t n) {
+    auto vals = std::vector<T>(n);
+    for (auto& v : vals)
+        v = rand_val<T>();
+    return vals;
+}
+
+/// @brief Sorting networks vs LSD for native types, as a multiple of the key size.
+template <typename T>
+size_t net_sort_factor(cav::Sorter<>& sorter, char const* name, size_t max_n) {
+    auto   origin = make_natives<T>(cav::max(max_n, min_tot_elems));
+    size_t cross  = crossover(
+        name,
+        origin,
+        4,
+        cav::min(max_n, size_t{4096}),
+        [&](cav::Span<T*> c) { sorter.net_sort(c); },
+        [&](cav::Span<T*> c) { sorter.radix_sort_lsd(c); });
+    return (cross == 0 ? 4096 : cross) / sizeof(T);
+}
+
+/// @brief Insertion sort vs LSD for struct-like types, as a multiple of the key size.
+template <typename T, size_t Sz>
+size_t small_sort_factor(cav::Sorter<>& sorter, char const* name, size_t max_n) {
+    using rec_t   = Record<T, Sz>;
+    auto   origin = make_values<rec_t, T>(cav::max(max_n, min_tot_elems));
+    size_t cross  = crossover(
+        name,
+        origin,
+        4,
+        cav::min(max_n, size_t{1024}),
+        [&](cav::Span<rec_t*> c) { sorter.insertion_sort(c, RecordKey{}); },
+        [&](cav::Span<rec_t*> c) { sorter.radix_sort_lsd(c, RecordKey{}); });
+    return (cross == 0 ? 1024 : cross) / sizeof(T);
+}
+
+/// @brief LSD vs MSD for struct-like types of Sz bytes with 8-bytes keys, 0 if not measured.
+template <size_t Sz>
+unsigned long long msd_thresh(cav::Sorter<>& sorter, char const* name, size_t max_n) {
+    using rec_t   = Record<double, Sz>;
+    auto   origin = make_values<rec_t, double>(cav::max(max_n, min_tot_elems));
+    size_t cross  = crossover(
+        name,
+        origin,
+        256,
+        max_n,
+        [&](cav::Span<rec_t*> c) { sorter.radix_sort_lsd(c, RecordKey{}); },
+        [&](cav::Span<rec_t*> c) { sorter.radix_sort_msd(c, RecordKey{}); });
+    return cross;
+}
+
+/// @brief LSD vs MSD for indexes sorted by an external array of 8-bytes keys, 0 if not measured.
+unsigned long long indirect_msd_thresh(cav::Sorter<>& sorter, size_t max_n) {
+    auto keys   = make_natives<int64_t>(cav::max(max_n, min_tot_elems));
+    auto origin = std::vector<uint32_t>(keys.size());
+    for (size_t i = 0; i < origin.size(); ++i)
+        origin[i] = static_cast<uint32_t>(i);
+    auto   key   = [&](uint32_t i) { return keys[i]; };
+    size_t cross = crossover(
+        "i64_ind",
+        origin,
+        256,
+        max_n,
+        [&](cav::Span<uint32_t*> c) { sorter.radix_sort_lsd(c, key); },
+        [&](cav::Span<uint32_t*> c) { sorter.radix_sort_msd(c, key); });
+    return cross;
+}
+
+/// @brief Full sort vs radix nth element.
+template <typename T, size_t Sz>
+size_t nth_elem_thresh(cav::Sorter<>& sorter, char const* name, size_t max_n) {
+    using rec_t   = Record<T, Sz>;
+    auto   origin = make_values<rec_t, T>(cav::max(max_n, min_tot_elems));
+    size_t cross  = crossover(
+        name,
+        origin,
+        4,
+        cav::min(max_n, size_t{1024}),
+        [&](cav::Span<rec_t*> c) { sorter.sort(c, RecordKey{}); },
+        [&](cav::Span<rec_t*> c) {
+            sorter.radix_nth_elem(c, cav::size(c) / 2, RecordKey{});
+        });
+    return cross == 0 ? 1024 : cross;
+}
+
+}  // namespace
+
+int main(int argc, char const** argv) {
+    auto args     = cav::make_span(argv, argc);
+    auto out_path = std::string(argc > 1 ? args[1] : "sort_tuned.hpp");
+    auto max_n    = size_t{1} << (argc > 2 ? std::stoi(args[2]) : 20);
+    auto sorter   = cav::Sorter<>();
+
+    fmt::print("Per size -> ns/elem of the current choice / ns/elem of the alternative\n\n");
+    fmt::print("Sorting networks vs LSD radix sort (native types)\n");
+    size_t net_factor = median({net_sort_factor<int8_t>(sorter, "int8_t", max_n),
+                                net_sort_factor<int16_t>(sorter, "int16_t", max_n),
+                                net_sort_factor<int32_t>(sorter, "int32_t", max_n),
+                                net_sort_factor<int64_t>(sorter, "int64_t", max_n),
+                                net_sort_factor<float>(sorter, "float", max_n),
+                                net_sort_factor<double>(sorter, "double", max_n)});
+
+    fmt::print("\nInsertion sort vs LSD radix sort (struct-like types)\n");
+    size_t small_factor = median({small_sort_factor<float, 16>(sorter, "flt_16B", max_n),
+                                  small_sort_factor<float, 64>(sorter, "flt_64B", max_n),
+                                  small_sort_factor<double, 16>(sorter, "dbl_16B", max_n),
+                                  small_sort_factor<double, 32>(sorter, "dbl_32B", max_n),
+                                  small_sort_factor<double, 64>(sorter, "dbl_64B", max_n)});
+
+    fmt::print("\nLSD vs MSD radix sort (struct-like types with 8-bytes keys)\n");
+    unsigned long long msd_val_thresh[] = {0,  // values smaller than the 8-byte keys
+                                           msd_thresh<8>(sorter, "dbl_8B", max_n),
+                                           msd_thresh<16>(sorter, "dbl_16B", max_n),
+                                           msd_thresh<24>(sorter, "dbl_24B", max_n),
+                                           msd_thresh<32>(sorter, "dbl_32B", max_n),
+                                           msd_thresh<40>(sorter, "dbl_40B", max_n),
+                                           msd_thresh<48>(sorter, "dbl_48B", max_n),
+                                           msd_thresh<56>(sorter, "dbl_56B", max_n),
+                                           msd_thresh<64>(sorter, "dbl_64B", max_n)};
+
+    fmt::print("\nLSD vs MSD radix sort (indirect keys)\n");
+    unsigned long long indirect_thresh = indirect_msd_thresh(sorter, max_n);
+
+    fmt::print("\nSort vs radix nth element\n");
+    size_t nth_thresh = median({nth_elem_thresh<int32_t, 4>(sorter, "int32_t", max_n),
+                                nth_elem_thresh<double, 8>(sorter, "double", max_n),
+                                nth_elem_thresh<double, 32>(sorter, "dbl_32B", max_n)});
+
+    auto out = fmt::output_file(out_path);
+    out.print("// Generated by the yasl autotune target, do not edit.\n");
+    out.print("// Largest size measured: {}\n\n", max_n);
+    out.print("#ifndef CAV_NET_SORT_KEY_FACTOR\n#define CAV_NET_SORT_KEY_FACTOR {}U\n#endif\n\n",
+              cav::max(net_factor, size_t{1}));
+    out.print("#ifndef CAV_SMALL_SORT_KEY_FACTOR\n"
+              "#define CAV_SMALL_SORT_KEY_FACTOR {}U\n#endif\n\n",
+              cav::max(small_factor, size_t{1}));
+    // A crossover above the measured sizes is unknown, not infinite: keep the handpicked default
+    unsigned long long msd_default[] = CAV_MSD_RDX_VAL_SIZE_THRESH_DEFAULT;
+    bool               msd_measured  = false;
+    for (unsigned long long thresh : msd_val_thresh)
+        msd_measured = msd_measured || thresh != 0;
+    if (!msd_measured) {
+        out.print("// CAV_MSD_RDX_VAL_SIZE_THRESH not measured (above {}), default kept\n\n",
+                  max_n);
+    } else {
+        out.print("#ifndef CAV_MSD_RDX_VAL_SIZE_THRESH\n#define CAV_MSD_RDX_VAL_SIZE_THRESH {{");
+        for (size_t i = 0; i < 9; ++i)
+            out.print("{}{}ULL",
+                      i == 0 ? "" : ", ",
+                      msd_val_thresh[i] != 0 ? msd_val_thresh[i] : msd_default[i]);
+        out.print("}}\n#endif\n");
+        for (size_t i = 1; i < 9; ++i)
+            if (msd_val_thresh[i] == 0)
+                out.print("// {}B values not measured (above {}), default kept\n", 8 * i, max_n);
+        out.print("\n");
+    }
+    if (indirect_thresh == 0)
+        out.print("// CAV_MSD_RDX_INDIRECT_THRESH not measured (above {}), default kept\n\n",
+                  max_n);
+    else
+        out.print("#ifndef CAV_MSD_RDX_INDIRECT_THRESH\n#define CAV_MSD_RDX_INDIRECT_THRESH {}ULL\n"
+                  "#endif\n\n",
+                  indirect_thresh);
+    out.print("#ifndef CAV_NTH_ELEM_SORT_THRESH\n#define CAV_NTH_ELEM_SORT_THRESH {}U\n#endif\n",
+              nth_thresh);
+    fmt::print("\nThresholds written to {}\n", out_path);
+
+    return EXIT_SUCCESS;
+}
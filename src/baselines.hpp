@@ -0,0 +1,150 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_SRC_BASELINES_HPP
+#define CAV_SRC_BASELINES_HPP
+
+/// Third-party and reference sorting algorithms the benchmarks compare Sorter against. Each
+/// baseline is a functor with a `name()` and a `operator()(Span<T*>, key)`; register a new one by
+/// adding it to for_each_baseline(). With the BENCH_BASELINES option (ON by default), CMake takes
+/// pdqsort and ska_sort from extern/ or fetches them at a pinned commit, and defines
+/// CAV_HAS_PDQSORT and CAV_HAS_SKA_SORT for the ones it finds.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Span.hpp"
+#include "sort_utils.hpp"
+
+#ifdef CAV_HAS_PDQSORT
+#include "pdqsort.h"
+#endif
+
+#ifdef CAV_HAS_SKA_SORT
+#include "ska_sort.hpp"
+#endif
+
+namespace cav {
+namespace bench {
+
+    struct StdSort {
+        static char const* name() {
+            return "std-sort";
+        }
+
+        template <typename T, typename K>
+        void operator()(Span<T*> c, K key) const {
+            std::sort(c.begin(), c.end(), sort::make_comp_wrap(key));
+        }
+    };
+
+    struct StdStableSort {
+        static char const* name() {
+            return "std-stable";
+        }
+
+        template <typename T, typename K>
+        void operator()(Span<T*> c, K key) const {
+            std::stable_sort(c.begin(), c.end(), sort::make_comp_wrap(key));
+        }
+    };
+
+    /// @brief Textbook LSD radix sort: one counting pass per byte of the normalized key, no
+    /// byte skipping and no small-size fallback.
+    struct LsdReference {
+        static char const* name() {
+            return "lsd-ref";
+        }
+
+        template <typename T, typename K>
+        void operator()(Span<T*> c, K key) const {
+            using ukey_t = no_cvr<decltype(to_uint(key(c[0])))>;
+
+            static auto buff = std::vector<T>();  // benchmarks are single threaded
+            buff.resize(c.size());
+            T* src = c.begin();
+            T* dst = buff.data();
+            for (size_t b = 0; b < sizeof(ukey_t); ++b) {
+                size_t counts[256] = {};
+                auto   digit       = [&](T const& v) {
+                    return static_cast<uint8_t>(to_uint(key(v)) >> (8U * b));
+                };
+                for (T const* p = src; p != src + c.size(); ++p)
+                    ++counts[digit(*p)];
+                size_t offset = 0;
+                for (size_t& cnt : counts) {
+                    size_t tmp = cnt;
+                    cnt        = offset;
+                    offset += tmp;
+                }
+                for (T const* p = src; p != src + c.size(); ++p)
+                    dst[counts[digit(*p)]++] = *p;
+                std::swap(src, dst);
+            }
+            if (src != c.begin())
+                std::copy(src, src + c.size(), c.begin());
+        }
+    };
+
+#ifdef CAV_HAS_PDQSORT
+    struct PdqSort {
+        static char const* name() {
+            return "pdq-sort";
+        }
+
+        template <typename T, typename K>
+        void operator()(Span<T*> c, K key) const {
+            pdqsort(c.begin(), c.end(), sort::make_comp_wrap(key));
+        }
+    };
+#endif
+
+#ifdef CAV_HAS_SKA_SORT
+    struct SkaSort {
+        static char const* name() {
+            return "ska-sort";
+        }
+
+        template <typename T, typename K>
+        void operator()(Span<T*> c, K key) const {
+            ska_sort(c.begin(), c.end(), key);
+        }
+    };
+#endif
+
+    /// @brief Calls `f(baseline)` for each registered baseline, in column order.
+    template <typename F>
+    void for_each_baseline(F&& f) {
+        f(StdSort{});
+        f(StdStableSort{});
+        f(LsdReference{});
+#ifdef CAV_HAS_PDQSORT
+        f(PdqSort{});
+#endif
+#ifdef CAV_HAS_SKA_SORT
+        f(SkaSort{});
+#endif
+    }
+
+    struct NameCollector {
+        std::vector<std::string>* names;
+
+        template <typename B>
+        void operator()(B const& /*baseline*/) const {
+            names->push_back(B::name());
+        }
+    };
+
+    inline std::vector<std::string> baseline_names() {
+        auto names = std::vector<std::string>();
+        for_each_baseline(NameCollector{&names});
+        return names;
+    }
+
+}  // namespace bench
+}  // namespace cav
+
+#endif /* CAV_SRC_BASELINES_HPP */
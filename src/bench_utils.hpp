@@ -0,0 +1,563 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_SRC_BENCH_UTILS_HPP
+#define CAV_SRC_BENCH_UTILS_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Span.hpp"
+#include "counting_allocator.hpp"
+#include "limits.hpp"
+#include "perf_counters.hpp"
+#include "sort.hpp"
+#include "utils.hpp"
+
+namespace cav {
+namespace bench {
+
+    ////////////////////////////////////////////////////////////////////////////
+    ////////////////////////// INPUT DISTRIBUTIONS /////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////
+    enum class Dist : uint8_t {
+        uniform,
+        sorted,
+        reverse,
+        nearly_sorted,
+        few_unique,
+        zipf,
+        organ_pipe,
+        normal,
+        narrow_range,
+        count
+    };
+
+    inline char const* dist_name(Dist dist) {
+        static char const* const names[] = {"uniform",
+                                            "sorted",
+                                            "reverse",
+                                            "nearly_sorted",
+                                            "few_unique",
+                                            "zipf",
+                                            "organ_pipe",
+                                            "normal",
+                                            "narrow_range"};
+        return names[static_cast<uint8_t>(dist)];
+    }
+
+    inline bool parse_dist(std::string const& name, Dist& dist) {
+        for (uint8_t d = 0; d < static_cast<uint8_t>(Dist::count); ++d)
+            if (name == dist_name(static_cast<Dist>(d))) {
+                dist = static_cast<Dist>(d);
+                return true;
+            }
+        return false;
+    }
+
+    /// @brief Generates `n` keys of type T following `dist`. Values span [-sqrt(max), sqrt(max)]
+    /// (or [0, sqrt(max)] for unsigned types), like the original benchmarks.
+    template <typename T, typename R>
+    std::vector<T> make_keys(Dist dist, size_t n, R& rng) {
+        double hi  = std::sqrt(static_cast<double>(limits<T>::max()));
+        double lo  = std::is_signed<T>::value ? -hi : 0.0;
+        double mid = std::is_integral<T>::value ? std::floor((lo + hi) / 2.0) : (lo + hi) / 2.0;
+
+        auto uniform = std::uniform_real_distribution<double>(lo, hi);
+        auto keys    = std::vector<T>(n);
+        switch (dist) {
+        case Dist::few_unique: {
+            T uniques[16];
+            for (T& u : uniques)
+                u = static_cast<T>(uniform(rng));
+            for (T& k : keys)
+                k = uniques[rng() % 16];
+            break;
+        }
+        case Dist::zipf: {  // s = 1.1 over 2^16 ranks spread on the range
+            constexpr size_t n_ranks = 1U << 16U;
+            auto             cdf     = std::vector<double>(n_ranks);
+            double           accum   = 0.0;
+            for (size_t r = 0; r < n_ranks; ++r)
+                cdf[r] = accum += 1.0 / std::pow(static_cast<double>(r + 1), 1.1);
+            auto   pick = std::uniform_real_distribution<double>(0.0, accum);
+            double step = (hi - lo) / n_ranks;
+            for (T& k : keys) {
+                auto rank = std::lower_bound(cdf.begin(), cdf.end(), pick(rng)) - cdf.begin();
+                k         = static_cast<T>(lo + static_cast<double>(rank) * step);
+            }
+            break;
+        }
+        case Dist::normal: {
+            auto normal = std::normal_distribution<double>(mid, (hi - lo) / 8.0);
+            for (T& k : keys)
+                k = static_cast<T>(clamp(normal(rng), lo, hi));
+            break;
+        }
+        case Dist::narrow_range: {
+            auto narrow = std::uniform_int_distribution<int>(-128, 127);
+            for (T& k : keys)
+                k = static_cast<T>(clamp(mid + narrow(rng), lo, hi));
+            break;
+        }
+        default:
+            for (T& k : keys)
+                k = static_cast<T>(uniform(rng));
+        }
+
+        switch (dist) {
+        case Dist::sorted:
+            std::sort(keys.begin(), keys.end());
+            break;
+        case Dist::reverse:
+            std::sort(keys.begin(), keys.end(), [](T a, T b) { return b < a; });
+            break;
+        case Dist::nearly_sorted:
+            std::sort(keys.begin(), keys.end());
+            for (size_t s = 0; s < n / 100 + 1; ++s)
+                std::swap(keys[rng() % n], keys[rng() % n]);
+            break;
+        case Dist::organ_pipe:
+            std::sort(keys.begin(), keys.begin() + n / 2);
+            std::sort(keys.begin() + n / 2, keys.end(), [](T a, T b) { return b < a; });
+            break;
+        default:
+            break;
+        }
+        return keys;
+    }
+
+    /// @brief Offsets of consecutive segments of about `seg_size` elements (+-1/8 jitter).
+    template <typename R>
+    std::vector<size_t> make_offsets(size_t tot_elems, size_t seg_size, R& rng) {
+        size_t jitter  = seg_size / 4;
+        auto   offsets = std::vector<size_t>{0};
+        while (offsets.back() < tot_elems) {
+            size_t seg = seg_size - seg_size / 8 + (jitter > 0 ? rng() % jitter : 0);
+            offsets.push_back(min(tot_elems, offsets.back() + max(seg, size_t{1})));
+        }
+        return offsets;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////// CONFIGURATION ///////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////
+    enum class Format : uint8_t {
+        table,
+        json,
+        csv
+    };
+
+    struct BenchConfig {
+        std::vector<size_t> segments    = {16, 256, 4096, 65536};
+        std::vector<Dist>   dists       = {Dist::uniform};
+        size_t              tot_elems   = 1U << 20U;
+        int                 reps        = 5;
+        int                 warmup      = 1;
+        bool                flush_cache = false;
+        bool                perf        = false;  // hardware counters per element
+        bool                mem         = false;  // memory sub-rows in the table
+        uint64_t            seed        = 42;
+        Format              format      = Format::table;
+    };
+
+    inline std::vector<std::string> split(std::string const& str) {
+        auto   tokens = std::vector<std::string>();
+        size_t beg    = 0;
+        for (size_t end = str.find(','); end != std::string::npos; end = str.find(',', beg)) {
+            tokens.push_back(str.substr(beg, end - beg));
+            beg = end + 1;
+        }
+        tokens.push_back(str.substr(beg));
+        return tokens;
+    }
+
+    inline void print_usage(char const* prog) {
+        fmt::print(stderr,
+                   "usage: {} [SEG...] [--seg N,..] [--dist NAME,..|all] [--elems N] [--reps N]\n"
+                   "          [--warmup N] [--flush] [--perf] [--mem] [--seed N]\n"
+                   "          [--format table|json|csv]\n"
+                   "distributions:",
+                   prog);
+        for (uint8_t d = 0; d < static_cast<uint8_t>(Dist::count); ++d)
+            fmt::print(stderr, " {}", dist_name(static_cast<Dist>(d)));
+        fmt::print(stderr, "\n");
+    }
+
+    /// @brief Parses the command line over the `cfg` defaults, bare numbers are segment sizes (like
+    /// the old benchmarks).
+    inline BenchConfig parse_args(int argc, char const** argv, BenchConfig cfg = BenchConfig()) {
+        auto args     = make_span(argv, argc);
+        auto segments = std::vector<size_t>();
+        auto fail     = [&] {
+            print_usage(args[0]);
+            std::exit(EXIT_FAILURE);
+        };
+
+        for (int i = 1; i < argc; ++i) {
+            auto arg  = std::string(args[i]);
+            auto next = [&] { return i + 1 < argc ? std::string(args[++i]) : (fail(), ""); };
+            if (arg == "--seg")
+                for (auto const& tok : split(next()))
+                    segments.push_back(std::stoul(tok));
+            else if (arg == "--dist") {
+                cfg.dists.clear();
+                for (auto const& tok : split(next())) {
+                    if (tok == "all")
+                        for (uint8_t d = 0; d < static_cast<uint8_t>(Dist::count); ++d)
+                            cfg.dists.push_back(static_cast<Dist>(d));
+                    else if (!parse_dist(tok, (cfg.dists.push_back(Dist{}), cfg.dists.back())))
+                        fail();
+                }
+            } else if (arg == "--elems")
+                cfg.tot_elems = std::stoul(next());
+            else if (arg == "--reps")
+                cfg.reps = std::stoi(next());
+            else if (arg == "--warmup")
+                cfg.warmup = std::stoi(next());
+            else if (arg == "--flush")
+                cfg.flush_cache = true;
+            else if (arg == "--perf")
+                cfg.perf = true;
+            else if (arg == "--mem")
+                cfg.mem = true;
+            else if (arg == "--seed")
+                cfg.seed = std::stoull(next());
+            else if (arg == "--format") {
+                auto fmt_name = next();
+                cfg.format    = fmt_name == "json"  ? Format::json
+                              : fmt_name == "csv"   ? Format::csv
+                              : fmt_name == "table" ? Format::table
+                                                    : (fail(), Format::table);
+            } else if (!arg.empty() && std::isdigit(arg[0]))
+                segments.push_back(std::stoul(arg));
+            else
+                fail();
+        }
+        if (!segments.empty())
+            cfg.segments = segments;
+        if (cfg.reps < 1 || cfg.tot_elems == 0)
+            fail();
+        return cfg;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////// MEASUREMENT ////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////
+    struct Summary {
+        double              median;
+        double              p10;
+        double              p90;
+        CounterValues       counters;  // mean per element over the reps (NaN if not measured)
+        double              peak_bytes   = NAN;  // peak scratch memory (NaN if not tracked)
+        double              allocs       = NAN;  // allocations, warm-up included (NaN: not tracked)
+        double              minor_faults = 0.0;  // per timed repetition
+        bool                valid        = true;
+        std::vector<double> samples;  // ns per element of each timed repetition, in order
+    };
+
+    inline Summary summarize(std::vector<double> samples) {
+        auto res    = Summary();
+        res.samples = samples;
+        std::sort(samples.begin(), samples.end());
+        auto pct = [&](double p) {
+            return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5)];
+        };
+        res.median = pct(0.5);
+        res.p10    = pct(0.1);
+        res.p90    = pct(0.9);
+        return res;
+    }
+
+    /// @brief Counter group shared by the measurements, opened on first use. If the counters are
+    /// not available it says why once, and the measurements go on without them.
+    inline PerfCounters& perf_counters() {
+        static PerfCounters pc;
+        static bool         warned = false;
+        if (!pc.available() && !warned) {
+            fmt::print(stderr, "warning: hardware counters disabled ({})\n", pc.error());
+            warned = true;
+        }
+        return pc;
+    }
+
+    /// @brief Evicts the caches by touching a buffer larger than the last level cache.
+    inline void flush_cache() {
+        static auto   buff = std::vector<char>(64U << 20U);
+        static size_t iter = 0;
+        ++iter;
+        for (size_t i = 0; i < buff.size(); i += 64)
+            buff[i] = static_cast<char>(buff[i] + iter);
+        static_cast<void>(*static_cast<char volatile*>(buff.data()));
+    }
+
+    /// @brief Runs `algo` on each segment of a fresh copy of `origin`, `cfg.warmup` times without
+    /// measuring and `cfg.reps` times measuring the ns per element (and the hardware counters with
+    /// `cfg.perf`). `check(seq)` validates the output of the last run. If `alloc` is given, the
+    /// scratch memory the algorithm gets through it is reported as well.
+    template <typename T, typename A, typename V>
+    Summary measure(BenchConfig const&         cfg,
+                    std::vector<T> const&      origin,
+                    std::vector<size_t> const& offsets,
+                    A                          algo,
+                    V                          check,
+                    AllocCounters*             alloc = nullptr) {
+        auto   seq      = origin;
+        auto   samples  = std::vector<double>();
+        auto   counters = CounterValues();
+        auto*  pc       = cfg.perf ? &perf_counters() : nullptr;
+        double n_elems  = static_cast<double>(origin.size());
+        long   faults   = 0;
+        if (alloc != nullptr)
+            alloc->reset();
+        uint64_t live0 = alloc != nullptr ? alloc->live_bytes : 0;
+        for (int r = 0; r < cfg.warmup + cfg.reps; ++r) {
+            std::copy(origin.begin(), origin.end(), seq.begin());
+            if (cfg.flush_cache)
+                flush_cache();
+
+            long flt0 = minor_page_faults();
+            if (pc != nullptr)
+                pc->start();
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t o = 0; o + 1 < offsets.size(); ++o)
+                algo(make_span(seq.data() + offsets[o], seq.data() + offsets[o + 1]));
+            auto t1 = std::chrono::steady_clock::now();
+            auto cv = pc != nullptr ? pc->stop() : CounterValues();
+
+            if (r < cfg.warmup)
+                continue;
+            faults += minor_page_faults() - flt0;
+            samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / n_elems);
+            for (size_t c = 0; c < n_counters; ++c)
+                counters.vals[c] += cv.vals[c] / (n_elems * cfg.reps);
+        }
+
+        auto res  = summarize(samples);
+        res.valid = check(static_cast<std::vector<T> const&>(seq));
+        for (size_t c = 0; c < n_counters; ++c)
+            res.counters.vals[c] = pc != nullptr ? counters.vals[c] : NAN;
+        res.minor_faults = static_cast<double>(faults) / cfg.reps;
+        if (alloc != nullptr) {
+            res.peak_bytes = static_cast<double>(alloc->peak_bytes - live0);
+            res.allocs     = static_cast<double>(alloc->allocs);
+        }
+        return res;
+    }
+
+    using BenchSorter = Sorter<uint32_t, CountingAllocator<char>>;
+
+    /// @brief measure() on a fresh BenchSorter, so that the scratch memory reported is the one
+    /// needed by `algo(sorter, span)` alone.
+    template <typename T, typename A, typename V>
+    Summary measure_sorter(BenchConfig const&         cfg,
+                           std::vector<T> const&      origin,
+                           std::vector<size_t> const& offsets,
+                           A                          algo,
+                           V                          check) {
+        auto alloc  = AllocCounters();
+        auto sorter = BenchSorter{BenchSorter::SorterData(CountingAllocator<char>(alloc))};
+        auto run    = [&](Span<T*> c) { algo(sorter, c); };
+        return measure(cfg, origin, offsets, run, check, &alloc);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////// REPORTING ////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////
+    /// @brief Prints the results as a table (median ns/element per algorithm), as CSV or as a JSON
+    /// array (one record per row and algorithm, with median, p10, p90 and every sample). With
+    /// `cfg.perf` the counters per element are added as sub-rows of the table, columns or a
+    /// "counters" object.
+    /// Peak scratch bytes, allocations and minor page faults are always in JSON/CSV, and in the
+    /// table as sub-rows with `cfg.mem`.
+    class Reporter {
+    public:
+        Reporter(BenchConfig const& cfg, std::string bench, std::vector<std::string> algos)
+            : cfg(cfg)
+            , bench(std::move(bench))
+            , algos(std::move(algos)) {
+            if (cfg.format == Format::csv) {
+                fmt::print("bench,type,dist,segment,elems,algo,median_ns,p10_ns,p90_ns,reps,valid,"
+                           "peak_bytes,allocs,minor_faults");
+                for (size_t c = 0; cfg.perf && c < n_counters; ++c)
+                    fmt::print(",{}", counter_name(static_cast<Counter>(c)));
+                fmt::print("\n");
+            }
+            if (cfg.format == Format::json)
+                fmt::print("[");
+        }
+
+        Reporter(Reporter const&)            = delete;
+        Reporter& operator=(Reporter const&) = delete;
+
+        ~Reporter() {
+            if (cfg.format == Format::json)
+                fmt::print("\n]\n");
+        }
+
+        void begin_row(std::string const& type, Dist dist, size_t segment) {
+            begin_row(type, std::string(dist_name(dist)), segment);
+        }
+
+        /// @brief Row of inputs not drawn from a Dist (e.g., replayed from a capture).
+        void begin_row(std::string const& type, std::string const& dist, size_t segment) {
+            row_type = type;
+            row_dist = dist;
+            row_seg  = segment;
+            row_sums.assign(algos.size(), Summary());
+            if (cfg.format != Format::table)
+                return;
+            if (!header_done) {
+                fmt::print("{:10} {:>13} {:>8} {:>8}", "type", "dist", "length", "samples");
+                for (auto const& algo : algos)
+                    fmt::print(" {:>10}", algo);
+                fmt::print("\n");
+                header_done = true;
+            }
+            fmt::print("{:10} {:>13} {:8} {:8}",
+                       type,
+                       dist,
+                       segment,
+                       cfg.tot_elems / max(segment, size_t{1}));
+        }
+
+        void add(size_t algo_idx, Summary const& s) {
+            auto const& algo   = algos[algo_idx];
+            row_sums[algo_idx] = s;
+            if (!s.valid) {
+                fmt::print(stderr,
+                           "error: {} gave a wrong result ({}, {}, {})\n",
+                           algo,
+                           row_type,
+                           row_dist,
+                           row_seg);
+                ++n_failures;
+            }
+            switch (cfg.format) {
+            case Format::table:
+                s.valid ? fmt::print(" {:>10.1f}", s.median) : fmt::print(" {:>10}", "WRONG");
+                break;
+            case Format::csv:
+                fmt::print("{},{},{},{},{},{},{:.3f},{:.3f},{:.3f},{},{:d},{},{},{:.1f}",
+                           bench,
+                           row_type,
+                           row_dist,
+                           row_seg,
+                           cfg.tot_elems,
+                           algo,
+                           s.median,
+                           s.p10,
+                           s.p90,
+                           cfg.reps,
+                           s.valid,
+                           nan_or(s.peak_bytes, ""),
+                           nan_or(s.allocs, ""),
+                           s.minor_faults);
+                for (size_t c = 0; cfg.perf && c < n_counters; ++c)  // empty if not available
+                    std::isnan(s.counters.vals[c]) ? fmt::print(",")
+                                                   : fmt::print(",{:.4f}", s.counters.vals[c]);
+                fmt::print("\n");
+                break;
+            case Format::json:
+                fmt::print("{}\n  {{\"bench\": \"{}\", \"type\": \"{}\", \"dist\": \"{}\", "
+                           "\"segment\": {}, \"elems\": {}, \"algo\": \"{}\", "
+                           "\"median_ns\": {}, \"p10_ns\": {}, \"p90_ns\": {}, "
+                           "\"reps\": {}, \"valid\": {}, \"peak_bytes\": {}, \"allocs\": {}, "
+                           "\"minor_faults\": {:.1f}",
+                           n_records++ == 0 ? "" : ",",
+                           bench,
+                           row_type,
+                           row_dist,
+                           row_seg,
+                           cfg.tot_elems,
+                           algo,
+                           json_ns(s.median),
+                           json_ns(s.p10),
+                           json_ns(s.p90),
+                           cfg.reps,
+                           s.valid,
+                           nan_or(s.peak_bytes, "null"),
+                           nan_or(s.allocs, "null"),
+                           s.minor_faults);
+                if (cfg.perf) {
+                    fmt::print(", \"counters\": {{");
+                    for (size_t c = 0; c < n_counters; ++c) {
+                        double      v    = s.counters.vals[c];
+                        char const* name = counter_name(static_cast<Counter>(c));
+                        fmt::print("{}\"{}\": ", c == 0 ? "" : ", ", name);
+                        std::isnan(v) ? fmt::print("null") : fmt::print("{:.4f}", v);
+                    }
+                    fmt::print("}}");
+                }
+                fmt::print(", \"samples_ns\": [");
+                for (size_t i = 0; i < s.samples.size(); ++i)
+                    fmt::print("{}{:.3f}", i == 0 ? "" : ", ", s.samples[i]);
+                fmt::print("]}}");
+                break;
+            }
+            std::fflush(stdout);
+        }
+
+        /// @brief Number of measurements whose output did not pass the check.
+        size_t failures() const noexcept {
+            return n_failures;
+        }
+
+        void end_row() {
+            if (cfg.format != Format::table)
+                return;
+            fmt::print("\n");
+            for (size_t c = 0; cfg.perf && c < n_counters; ++c) {
+                char const* name = counter_name(static_cast<Counter>(c));
+                fmt::print("{:10} {:>13} {:>17}", "", name, "/elem");
+                for (Summary const& s : row_sums)
+                    fmt::print(" {:>10.2f}", s.counters.vals[c]);
+                fmt::print("\n");
+            }
+            if (!cfg.mem)
+                return;
+            fmt::print("{:10} {:>13} {:>17}", "", "scratch", "KiB");
+            for (Summary const& s : row_sums)
+                fmt::print(" {:>10.1f}", s.peak_bytes / 1024.0);
+            fmt::print("\n{:10} {:>13} {:>17}", "", "allocs", "");
+            for (Summary const& s : row_sums)
+                fmt::print(" {:>10.0f}", s.allocs);
+            fmt::print("\n{:10} {:>13} {:>17}", "", "minor_faults", "/rep");
+            for (Summary const& s : row_sums)
+                fmt::print(" {:>10.1f}", s.minor_faults);
+            fmt::print("\n");
+        }
+
+    private:
+        static std::string nan_or(double v, char const* nan_str) {
+            return std::isnan(v) ? nan_str : fmt::format("{:.0f}", v);
+        }
+
+        static std::string json_ns(double v) {
+            return std::isnan(v) ? "null" : fmt::format("{:.3f}", v);
+        }
+
+        BenchConfig const&       cfg;
+        std::string              bench;
+        std::vector<std::string> algos;
+        std::vector<Summary>     row_sums;
+        std::string              row_type;
+        std::string              row_dist;
+        size_t                   row_seg     = 0;
+        size_t                   n_records   = 0;
+        size_t                   n_failures  = 0;
+        bool                     header_done = false;
+    };
+
+}  // namespace bench
+}  // namespace cav
+
+#endif /* CAV_SRC_BENCH_UTILS_HPP */
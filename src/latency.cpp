@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Tail latency benchmark: times each call of many small sorts instead of the whole loop, and
+// reports p50/p90/p99/p99.9/max per size class together with a log2 histogram (JSON). Three
+// scenarios isolate the sources of the tail:
+//  - warm-fixed: buffer already grown, every call of the same size (hot code and data);
+//  - warm-mixed: buffer already grown, sizes drawn in [size/2, 3*size/2], so consecutive calls
+//    jump around the network switch and the dispatch thresholds (i-cache, branch predictor);
+//  - cold-mixed: like warm-mixed on a fresh Sorter, so the calls growing the buffer in
+//    SorterData::get_sized_buff and the page faults of the new buffer are measured too.
+// Each call is timed with steady_clock (~20ns of overhead on Linux/x86 with vDSO).
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ClassType.hpp"
+#include "Span.hpp"
+#include "counting_allocator.hpp"
+#include "bench_utils.hpp"
+#include "sort.hpp"
+#include "sort_stats.hpp"
+
+namespace bench = cav::bench;
+
+namespace {
+
+using StatsSorter = cav::Sorter<uint32_t, std::allocator<char>, cav::SortStats>;
+
+enum class Scenario : uint8_t {
+    warm_fixed,
+    warm_mixed,
+    cold_mixed,
+    count
+};
+
+char const* scenario_name(Scenario sc) {
+    static char const* const names[] = {"warm-fixed", "warm-mixed", "cold-mixed"};
+    return names[static_cast<uint8_t>(sc)];
+}
+
+struct LatencyStats {
+    size_t                calls        = 0;
+    uint64_t              pcts[5]      = {};  // p50, p90, p99, p99.9, max (ns)
+    size_t                reallocs     = 0;   // calls that grew the Sorter buffer
+    uint64_t              realloc_max  = 0;   // slowest of them (ns)
+    long                  minor_faults = 0;
+    std::vector<uint64_t> histogram;  // histogram[b]: calls in [2^b, 2^(b+1)) ns
+};
+
+/// @brief Runs each call of `algo` on the segments of `seq` timing it, returns the statistics.
+template <typename T, typename F>
+LatencyStats time_calls(std::vector<T>&            seq,
+                        std::vector<size_t> const& offsets,
+                        StatsSorter&               sorter,
+                        F                          algo) {
+    auto lat  = std::vector<uint64_t>(offsets.size() - 1);
+    auto res  = LatencyStats();
+    long flt0 = cav::minor_page_faults();
+    for (size_t o = 0; o + 1 < offsets.size(); ++o) {
+        auto   span     = cav::make_span(seq.data() + offsets[o], seq.data() + offsets[o + 1]);
+        size_t reallocs = sorter.stats().buff_reallocs;
+        auto   t0       = std::chrono::steady_clock::now();
+        algo(span);
+        auto t1 = std::chrono::steady_clock::now();
+        lat[o]  = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        if (sorter.stats().buff_reallocs != reallocs) {
+            ++res.reallocs;
+            res.realloc_max = cav::max(res.realloc_max, lat[o]);
+        }
+    }
+    res.minor_faults = cav::minor_page_faults() - flt0;
+    res.calls        = lat.size();
+
+    res.histogram.assign(64, 0);
+    for (uint64_t ns : lat) {
+        size_t b = 0;
+        while ((ns >> (b + 1)) != 0)
+            ++b;
+        ++res.histogram[b];
+    }
+    std::sort(lat.begin(), lat.end());
+    double const qs[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+    for (size_t q = 0; q < 5; ++q)
+        res.pcts[q] = lat[static_cast<size_t>(qs[q] * static_cast<double>(lat.size() - 1))];
+    return res;
+}
+
+class LatencyReporter {
+public:
+    explicit LatencyReporter(bench::BenchConfig const& cfg)
+        : cfg(cfg) {
+        if (cfg.format == bench::Format::table)
+            fmt::print("{:8} {:>12} {:>9} {:6} {:>8} {:>8} {:>8} {:>8} {:>8} {:>9} {:>9} {:>10}\n",
+                       "type",
+                       "scenario",
+                       "algo",
+                       "size",
+                       "calls",
+                       "p50",
+                       "p90",
+                       "p99",
+                       "p99.9",
+                       "max",
+                       "reallocs",
+                       "flt/kcall");
+        if (cfg.format == bench::Format::csv)
+            fmt::print("type,dist,scenario,algo,size,calls,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,"
+                       "reallocs,realloc_max_ns,minor_faults\n");
+        if (cfg.format == bench::Format::json)
+            fmt::print("[");
+    }
+
+    LatencyReporter(LatencyReporter const&)            = delete;
+    LatencyReporter& operator=(LatencyReporter const&) = delete;
+
+    ~LatencyReporter() {
+        if (cfg.format == bench::Format::json)
+            fmt::print("\n]\n");
+    }
+
+    void add(char const*         type,
+             bench::Dist         dist,
+             Scenario            sc,
+             char const*         algo,
+             size_t              size,
+             LatencyStats const& s) {
+        uint64_t const* p = s.pcts;
+        switch (cfg.format) {
+        case bench::Format::table:
+            fmt::print("{:8} {:>12} {:>9} {:6} {:8} {:8} {:8} {:8} {:8} {:9} {:9} {:10.1f}\n",
+                       type,
+                       scenario_name(sc),
+                       algo,
+                       size,
+                       s.calls,
+                       p[0],
+                       p[1],
+                       p[2],
+                       p[3],
+                       p[4],
+                       s.reallocs,
+                       1e3 * static_cast<double>(s.minor_faults) / static_cast<double>(s.calls));
+            break;
+        case bench::Format::csv:
+            fmt::print("{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                       type,
+                       bench::dist_name(dist),
+                       scenario_name(sc),
+                       algo,
+                       size,
+                       s.calls,
+                       p[0],
+                       p[1],
+                       p[2],
+                       p[3],
+                       p[4],
+                       s.reallocs,
+                       s.realloc_max,
+                       s.minor_faults);
+            break;
+        case bench::Format::json:
+            fmt::print("{}\n  {{\"type\": \"{}\", \"dist\": \"{}\", \"scenario\": \"{}\", "
+                       "\"algo\": \"{}\", \"size\": {}, \"calls\": {}, \"p50_ns\": {}, "
+                       "\"p90_ns\": {}, \"p99_ns\": {}, \"p999_ns\": {}, \"max_ns\": {}, "
+                       "\"reallocs\": {}, \"realloc_max_ns\": {}, \"minor_faults\": {}, "
+                       "\"histogram\": [",
+                       n_records++ == 0 ? "" : ",",
+                       type,
+                       bench::dist_name(dist),
+                       scenario_name(sc),
+                       algo,
+                       size,
+                       s.calls,
+                       p[0],
+                       p[1],
+                       p[2],
+                       p[3],
+                       p[4],
+                       s.reallocs,
+                       s.realloc_max,
+                       s.minor_faults);
+            char const* sep = "";
+            for (size_t b = 0; b < s.histogram.size(); ++b)
+                if (s.histogram[b] > 0) {
+                    fmt::print("{}[{}, {}]", sep, uint64_t{1} << b, s.histogram[b]);
+                    sep = ", ";
+                }
+            fmt::print("]}}");
+            break;
+        }
+        std::fflush(stdout);
+    }
+
+private:
+    bench::BenchConfig const& cfg;
+    size_t                    n_records = 0;
+};
+
+/// @brief Offsets of `n_calls` segments of `size` elements, or of sizes in [size/2, 3*size/2].
+template <typename R>
+std::vector<size_t> make_calls(size_t n_calls, size_t size, bool mixed, R& rng) {
+    auto offsets = std::vector<size_t>{0};
+    for (size_t c = 0; c < n_calls; ++c)
+        offsets.push_back(offsets.back() + (mixed ? size / 2 + rng() % (size + 1) : size));
+    return offsets;
+}
+
+template <typename T, typename K>
+void run_test(char const*               name,
+              LatencyReporter&          rep,
+              bench::BenchConfig const& cfg,
+              bench::Dist               dist,
+              size_t                    size,
+              K                         key) {
+    size_t n_calls = cav::max(cfg.tot_elems / cav::max(size, size_t{1}), size_t{100});
+    auto   warm    = StatsSorter();
+    for (uint8_t s = 0; s < static_cast<uint8_t>(Scenario::count); ++s) {
+        auto sc      = static_cast<Scenario>(s);
+        auto rng     = std::mt19937_64(cfg.seed);
+        auto offsets = make_calls(n_calls, size, sc != Scenario::warm_fixed, rng);
+        auto keys    = bench::make_keys<decltype(key(T{}))>(dist, offsets.back(), rng);
+        auto origin  = std::vector<T>(keys.begin(), keys.end());
+        auto seq     = origin;
+
+        auto cold = StatsSorter();
+        if (sc != Scenario::cold_mixed)  // grow the buffer before measuring
+            time_calls(seq, offsets, warm, [&](cav::Span<T*> c) { warm.sort(c, key); });
+        StatsSorter& sorter = sc == Scenario::cold_mixed ? cold : warm;
+
+        std::copy(origin.begin(), origin.end(), seq.begin());
+        auto cav_sort = [&](cav::Span<T*> c) { sorter.sort(c, key); };
+        rep.add(name, dist, sc, "cav-sort", size, time_calls(seq, offsets, sorter, cav_sort));
+
+        std::copy(origin.begin(), origin.end(), seq.begin());
+        auto std_sort = [&](cav::Span<T*> c) {
+            std::sort(c.begin(), c.end(), cav::sort::make_comp_wrap(key));
+        };
+        rep.add(name, dist, sc, "std-sort", size, time_calls(seq, offsets, sorter, std_sort));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char const** argv) {
+    auto cfg = bench::parse_args(argc, argv);
+
+    LatencyReporter rep(cfg);
+
+    for (bench::Dist dist : cfg.dists)
+        for (size_t size : cfg.segments) {
+            run_test<int32_t>("int32_t", rep, cfg, dist, size, [](int32_t a) { return a; });
+            run_test<double>("double", rep, cfg, dist, size, [](double a) { return a; });
+            run_test<cav::ClassType<double, 64>>(
+                "dbl_64B", rep, cfg, dist, size, [](cav::ClassType<double, 64> const& a) {
+                    return double(a);
+                });
+        }
+
+    return EXIT_SUCCESS;
+}
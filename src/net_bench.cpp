@@ -0,0 +1,185 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Sorting networks microbenchmark, the measurement behind the table in sorting_networks.hpp: each
+// row sorts many independent chunks of exactly `length` elements (2 to 64 by default) and reports
+// the ns per element of:
+//  - net-switch: Sorter::net_sort, i.e. the net_dispatch switch up to CAV_MAX_NET_SIZE, networks
+//    of CAV_MAX_NET_SIZE elements plus merges above it;
+//  - net-jump:   the same networks called through a table of function pointers (nan above 32);
+//  - insertion:  Sorter::insertion_sort;
+//  - std-sort:   std::sort.
+// Rebuild with a different -DCAV_MAX_NET_SIZE=<N>U to see how the network size limit affects the
+// switch, and run the `net_code_size` target to get the code size of each network instantiation.
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ClassType.hpp"
+#include "Span.hpp"
+#include "bench_utils.hpp"
+#include "sort.hpp"
+#include "sorting_networks.hpp"
+
+namespace bench = cav::bench;
+
+namespace {
+
+/// @brief Trivially copyable record of P bytes, sorted through the memcpy cmp_swap.
+template <typename T, size_t P>
+struct Pod {
+    T    elem;
+    char data[P - sizeof(T)];
+};
+
+/// @brief net_dispatch alternative selecting the network through a table of function pointers.
+/// Taking the addresses also keeps one out-of-line copy of each network in the binary, which is
+/// what `net_code_size` measures.
+template <typename C, typename K>
+void net_jump(C& container, K key) {
+    using namespace cav::netsort;
+    using net_fn               = void (*)(C&, K);
+    static net_fn const nets[] = {s0<C, K>,  s1<C, K>,  s2<C, K>,  s3<C, K>,  s4<C, K>,
+                                  s5<C, K>,  s6<C, K>,  s7<C, K>,  s8<C, K>,  s9<C, K>,
+                                  s10<C, K>, s11<C, K>, s12<C, K>, s13<C, K>, s14<C, K>,
+                                  s15<C, K>, s16<C, K>, s17<C, K>, s18<C, K>, s19<C, K>,
+                                  s20<C, K>, s21<C, K>, s22<C, K>, s23<C, K>, s24<C, K>,
+                                  s25<C, K>, s26<C, K>, s27<C, K>, s28<C, K>, s29<C, K>,
+                                  s30<C, K>, s31<C, K>, s32<C, K>};
+    assert(cav::size(container) < sizeof(nets) / sizeof(nets[0]));
+    nets[cav::size(container)](container, key);
+}
+
+constexpr size_t max_jump_size = 32;
+
+template <typename T, typename K>
+void run_row(bench::Reporter&           rep,
+             bench::BenchConfig const&  cfg,
+             std::vector<T> const&      origin,
+             std::vector<size_t> const& offsets,
+             size_t                     length,
+             K                          key) {
+    auto expected = origin;
+    for (size_t o = 0; o + 1 < offsets.size(); ++o)
+        std::stable_sort(expected.begin() + offsets[o],
+                         expected.begin() + offsets[o + 1],
+                         cav::sort::make_comp_wrap(key));
+    auto matches = [&](std::vector<T> const& seq) {
+        for (size_t i = 0; i < seq.size(); ++i)
+            if (key(seq[i]) != key(expected[i]))
+                return false;
+        return true;
+    };
+
+    using Sorter   = bench::BenchSorter;
+    auto cmp_key   = cav::sort::make_cmp_key<cav::Span<T*>>(key);
+    auto net_sort  = [&](Sorter& sorter, cav::Span<T*> c) { sorter.net_sort(c, key); };
+    auto ins_sort  = [&](Sorter& sorter, cav::Span<T*> c) { sorter.insertion_sort(c, key); };
+    auto jump_sort = [&](cav::Span<T*> c) { net_jump(c, cmp_key); };
+    auto std_sort  = [&](cav::Span<T*> c) {
+        std::sort(c.begin(), c.end(), cav::sort::make_comp_wrap(key));
+    };
+    auto no_net   = bench::Summary();  // reported as nan, there is no network of this size
+    no_net.median = no_net.p10 = no_net.p90 = NAN;
+    for (double& val : no_net.counters.vals)
+        val = NAN;
+    rep.add(0, bench::measure_sorter(cfg, origin, offsets, net_sort, matches));
+    rep.add(1,
+            length <= max_jump_size ? bench::measure(cfg, origin, offsets, jump_sort, matches)
+                                    : no_net);
+    rep.add(2, bench::measure_sorter(cfg, origin, offsets, ins_sort, matches));
+    rep.add(3, bench::measure(cfg, origin, offsets, std_sort, matches));
+    rep.end_row();
+}
+
+/// @brief Chunks of exactly `length` elements (sorting networks have a fixed size).
+std::vector<size_t> make_chunks(size_t tot_elems, size_t length) {
+    auto offsets = std::vector<size_t>{0};
+    while (offsets.back() + length <= tot_elems)
+        offsets.push_back(offsets.back() + length);
+    return offsets;
+}
+
+template <typename T>
+void run_test(char const*               name,
+              bench::Reporter&          rep,
+              bench::BenchConfig const& cfg,
+              bench::Dist               dist,
+              size_t                    length) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto offsets = make_chunks(cfg.tot_elems, length);
+    auto origin  = bench::make_keys<T>(dist, offsets.back(), rng);
+    rep.begin_row(name, dist, length);
+    run_row(rep, cfg, origin, offsets, length, [](T const& a) { return a; });
+}
+
+template <typename T, size_t P>
+void run_test_fat(char const*               name,
+                  bench::Reporter&          rep,
+                  bench::BenchConfig const& cfg,
+                  bench::Dist               dist,
+                  size_t                    length) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto offsets = make_chunks(cfg.tot_elems, length);
+    auto keys    = bench::make_keys<T>(dist, offsets.back(), rng);
+    auto origin  = std::vector<cav::ClassType<T, P>>();
+    origin.reserve(keys.size());
+    for (T k : keys)
+        origin.emplace_back(k);
+    rep.begin_row(name, dist, length);
+    run_row(rep, cfg, origin, offsets, length, [](cav::ClassType<T, P> const& a) { return T(a); });
+}
+
+template <typename T, size_t P>
+void run_test_pod(char const*               name,
+                  bench::Reporter&          rep,
+                  bench::BenchConfig const& cfg,
+                  bench::Dist               dist,
+                  size_t                    length) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto offsets = make_chunks(cfg.tot_elems, length);
+    auto keys    = bench::make_keys<T>(dist, offsets.back(), rng);
+    auto origin  = std::vector<Pod<T, P>>(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        origin[i] = Pod<T, P>{keys[i], {}};
+    rep.begin_row(name, dist, length);
+    run_row(rep, cfg, origin, offsets, length, [](Pod<T, P> const& a) { return a.elem; });
+}
+
+}  // namespace
+
+int main(int argc, char const** argv) {
+    auto defaults      = bench::BenchConfig();
+    defaults.tot_elems = 1U << 16U;  // hot in cache, like the networks in a real sort
+    defaults.segments.clear();
+    for (size_t n = 2; n <= 64; ++n)
+        defaults.segments.push_back(n);
+
+    auto cfg   = bench::parse_args(argc, argv, defaults);
+    auto algos = std::vector<std::string>{"net-switch", "net-jump", "insertion", "std-sort"};
+
+    bench::Reporter rep(cfg, "net_bench", algos);
+
+    for (bench::Dist dist : cfg.dists)
+        for (size_t len : cfg.segments) {
+            // natives
+            run_test<int32_t>("int32_t", rep, cfg, dist, len);
+            run_test<int64_t>("int64_t", rep, cfg, dist, len);
+            run_test<float>("float", rep, cfg, dist, len);
+            run_test<double>("double", rep, cfg, dist, len);
+
+            // struct like, moved (ClassType) or memcpy'd (Pod) by the networks
+            run_test_fat<double, 16>("dbl_16B", rep, cfg, dist, len);
+            run_test_fat<double, 32>("dbl_32B", rep, cfg, dist, len);
+            run_test_fat<double, 64>("dbl_64B", rep, cfg, dist, len);
+            run_test_pod<double, 64>("pod_64B", rep, cfg, dist, len);
+        }
+
+    return rep.failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,51 @@
+# SPDX-FileCopyrightText: 2024 Francesco Cavaliere
+# SPDX-License-Identifier: MIT
+
+# Prints the code size of each sorting network instantiated in the net_bench binary, for every
+# value type it sorts (the out-of-line copies kept by its jump table, see src/net_bench.cpp).
+# Usage: cmake -DNM=<nm> -DBINARY=<path/to/net_bench> -P net_code_size.cmake
+
+set(symbols_file ${CMAKE_CURRENT_BINARY_DIR}/net_bench_symbols.txt)
+execute_process(COMMAND ${NM} -C -S -t d ${BINARY}
+                OUTPUT_FILE ${symbols_file}
+                RESULT_VARIABLE nm_result)
+if (NOT nm_result EQUAL 0)
+    message(FATAL_ERROR "${NM} failed on ${BINARY}")
+endif()
+
+file(STRINGS ${symbols_file} lines REGEX "cav::netsort::s[0-9]+<")
+set(sym_regex "^[0-9]+ ([0-9]+) [A-Za-z] void cav::netsort::s([0-9]+)<cav::Span<([^*]*)\\*>")
+set(entries "")
+set(types "")
+foreach (line IN LISTS lines)
+    if (line MATCHES "${sym_regex}")
+        math(EXPR bytes "${CMAKE_MATCH_1}")  # drops the leading zeros
+        set(net_size ${CMAKE_MATCH_2})
+        string(REPLACE ", " "," type "${CMAKE_MATCH_3}")
+        if (net_size LESS 10)
+            set(net_size "0${net_size}")
+        endif()
+        list(APPEND entries "${type}|${net_size}|${bytes}")
+        list(APPEND types "${type}")
+    endif()
+endforeach()
+if (NOT entries)
+    message(FATAL_ERROR "No sorting network found in ${BINARY}")
+endif()
+
+list(REMOVE_DUPLICATES types)
+list(SORT entries)
+foreach (type IN LISTS types)
+    message("${type}")
+    set(total 0)
+    foreach (entry IN LISTS entries)
+        string(REPLACE "|" ";" fields "${entry}")
+        list(GET fields 0 entry_type)
+        if (entry_type STREQUAL type)
+            list(GET fields 1 net_size)
+            list(GET fields 2 bytes)
+            math(EXPR total "${total} + ${bytes}")
+            message("  s${net_size}: ${bytes} B (cumulative ${total} B)")
+        endif()
+    endforeach()
+endforeach()
@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#ifndef CAV_SRC_PERF_COUNTERS_HPP
+#define CAV_SRC_PERF_COUNTERS_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace cav {
+namespace bench {
+
+    enum class Counter : uint8_t {
+        cycles,
+        instructions,
+        branch_misses,
+        l1d_misses,
+        llc_misses,
+        dtlb_misses,
+        count
+    };
+
+    constexpr size_t n_counters = static_cast<size_t>(Counter::count);
+
+    inline char const* counter_name(Counter c) {
+        static char const* const names[] = {
+            "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses", "dtlb_misses"};
+        return names[static_cast<uint8_t>(c)];
+    }
+
+    struct CounterValues {
+        double vals[n_counters] = {};  // NaN when the counter is not available
+    };
+
+    /// @brief Group of hardware counters of the calling thread (user space only), read through
+    /// perf_event_open. Counters the kernel or the PMU refuse are skipped; if even the cycles
+    /// leader cannot be opened (non-Linux, containers, perf_event_paranoid > 2) the group is
+    /// unavailable, every value reads as NaN and error() tells why.
+    class PerfCounters {
+    public:
+        PerfCounters() {
+#ifdef __linux__
+            for (size_t c = 0; c < n_counters; ++c) {
+                fds[c] = _open(static_cast<Counter>(c), c == 0 ? -1 : fds[0]);
+                if (fds[c] >= 0)
+                    slot[c] = static_cast<int>(n_open++);
+                else if (c == 0) {
+                    err = std::string("perf_event_open: ") + std::strerror(errno);
+                    return;
+                }
+            }
+#else
+            err = "perf_event_open: not supported on this platform";
+#endif
+        }
+
+        PerfCounters(PerfCounters const&)            = delete;
+        PerfCounters& operator=(PerfCounters const&) = delete;
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (int fd : fds)
+                if (fd >= 0)
+                    close(fd);
+#endif
+        }
+
+        bool available() const noexcept {
+            return n_open > 0;
+        }
+
+        std::string const& error() const noexcept {
+            return err;
+        }
+
+        void start() noexcept {
+#ifdef __linux__
+            if (!available())
+                return;
+            ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        /// @brief Stops the group and returns the counts since start(), scaled by the fraction of
+        /// time the group was actually scheduled on the PMU.
+        CounterValues stop() noexcept {
+            auto res = CounterValues();
+            for (double& v : res.vals)
+                v = NAN;
+#ifdef __linux__
+            if (!available())
+                return res;
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+            uint64_t buff[3 + n_counters] = {};  // nr, time_enabled, time_running, values...
+            if (read(fds[0], buff, sizeof(buff)) < 0 || buff[2] == 0)
+                return res;
+            double scale = static_cast<double>(buff[1]) / static_cast<double>(buff[2]);
+            for (size_t c = 0; c < n_counters; ++c)
+                if (slot[c] >= 0)
+                    res.vals[c] = static_cast<double>(buff[3 + slot[c]]) * scale;
+#endif
+            return res;
+        }
+
+    private:
+#ifdef __linux__
+        static int _open(Counter c, int group_fd) {
+            auto attr = perf_event_attr();
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.disabled       = group_fd < 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            auto cache_miss = [](uint64_t cache) {
+                return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+            };
+            attr.type = PERF_TYPE_HARDWARE;
+            switch (c) {
+            case Counter::cycles:
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case Counter::instructions:
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case Counter::branch_misses:
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case Counter::l1d_misses:
+                attr.type   = PERF_TYPE_HW_CACHE;
+                attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+                break;
+            case Counter::llc_misses:
+                attr.type   = PERF_TYPE_HW_CACHE;
+                attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+                break;
+            default:
+                attr.type   = PERF_TYPE_HW_CACHE;
+                attr.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+                break;
+            }
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+        }
+#endif
+
+        int         fds[n_counters]  = {-1, -1, -1, -1, -1, -1};
+        int         slot[n_counters] = {-1, -1, -1, -1, -1, -1};  // position in the group read
+        size_t      n_open           = 0;
+        std::string err;
+    };
+
+}  // namespace bench
+}  // namespace cav
+
+#endif /* CAV_SRC_PERF_COUNTERS_HPP */
@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Replay benchmark: reads a workload recorded by WorkloadCapture (see workload_capture.hpp) and,
+// for each captured shape (key kind, key size, value size), sorts inputs generated to match it:
+// the call sizes are drawn from the recorded ones and each byte of the keys from the recorded
+// byte histograms (independently). Rows report the ns per element like the sort benchmark, the
+// `length` column is the median recorded size. Usage: replay WORKLOAD [options], where the
+// options are the ones of the other benchmarks (--seg and --dist are ignored).
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Span.hpp"
+#include "bench_utils.hpp"
+#include "sort.hpp"
+#include "sort_utils.hpp"
+#include "utils.hpp"
+#include "workload_capture.hpp"
+
+namespace bench = cav::bench;
+
+namespace {
+
+template <typename T, size_t P>
+struct Pod {
+    T    elem;
+    char data[P > sizeof(T) ? P - sizeof(T) : 1];
+};
+
+/// @brief Inverse of key_traits::to_uint for the key types the replay generates.
+template <typename T, typename U>
+auto from_ukey(U ukey) -> CAV_REQUIRES_T(T, std::is_integral<T>::value) {
+    return static_cast<T>(static_cast<U>(ukey - cav::key_traits<T>::to_uint(T{})));
+}
+
+template <typename T, typename U>
+auto from_ukey(U ukey) -> CAV_REQUIRES_T(T, std::is_floating_point<T>::value) {
+    constexpr U sign_bit = U{1} << (8U * sizeof(U) - 1U);
+    return cav::bit_cast<T>(static_cast<U>((ukey & sign_bit) != 0 ? ukey ^ sign_bit : ~ukey));
+}
+
+/// @brief Keys whose bytes follow the histograms of `shape` (NaNs are drawn again).
+template <typename T, typename R>
+std::vector<T> make_replay_keys(cav::WorkloadShape const& shape, size_t n, R& rng) {
+    using ukey_t = typename cav::uint_of_size<sizeof(T)>::type;
+    auto digits  = std::vector<std::discrete_distribution<int>>();
+    for (size_t b = 0; b < shape.byte_hist.size() && b < sizeof(T); ++b) {
+        auto const& hist = shape.byte_hist[b];
+        if (std::all_of(hist.begin(), hist.end(), [](uint64_t c) { return c == 0; }))
+            digits.emplace_back(std::initializer_list<double>{1.0});  // always 0
+        else
+            digits.emplace_back(hist.begin(), hist.end());
+    }
+
+    auto keys = std::vector<T>(n);
+    for (T& key : keys)
+        do {
+            ukey_t ukey = 0;
+            for (size_t b = 0; b < digits.size(); ++b)
+                ukey |= static_cast<ukey_t>(static_cast<ukey_t>(digits[b](rng)) << (8U * b));
+            key = from_ukey<T>(ukey);
+        } while (std::isnan(static_cast<double>(key)));
+    return keys;
+}
+
+/// @brief Offsets of calls whose sizes are drawn from the recorded ones, up to `tot_elems`.
+template <typename R>
+std::vector<size_t> make_replay_calls(cav::WorkloadShape const& shape, size_t tot_elems, R& rng) {
+    auto offsets = std::vector<size_t>{0};
+    auto pick    = std::uniform_int_distribution<size_t>(0, shape.sizes.size() - 1);
+    while (offsets.back() < tot_elems)
+        offsets.push_back(offsets.back() + shape.sizes[pick(rng)]);
+    return offsets;
+}
+
+template <typename T, typename K>
+void run_row(bench::Reporter&           rep,
+             bench::BenchConfig const&  cfg,
+             std::vector<T> const&      origin,
+             std::vector<size_t> const& offsets,
+             K                          key) {
+    auto expected = origin;
+    for (size_t o = 0; o + 1 < offsets.size(); ++o)
+        std::stable_sort(expected.begin() + offsets[o],
+                         expected.begin() + offsets[o + 1],
+                         cav::sort::make_comp_wrap(key));
+    auto matches = [&](std::vector<T> const& seq) {
+        for (size_t i = 0; i < seq.size(); ++i)
+            if (key(seq[i]) != key(expected[i]))
+                return false;
+        return true;
+    };
+
+    using Sorter  = bench::BenchSorter;
+    auto lsd_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.radix_sort_lsd(c, key); };
+    auto msd_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.radix_sort_msd(c, key); };
+    auto cav_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.sort(c, key); };
+    auto std_sort = [&](cav::Span<T*> c) {
+        std::sort(c.begin(), c.end(), cav::sort::make_comp_wrap(key));
+    };
+    rep.add(0, bench::measure_sorter(cfg, origin, offsets, cav_sort, matches));
+    rep.add(1, bench::measure_sorter(cfg, origin, offsets, lsd_sort, matches));
+    rep.add(2, bench::measure_sorter(cfg, origin, offsets, msd_sort, matches));
+    rep.add(3, bench::measure(cfg, origin, offsets, std_sort, matches));
+    rep.end_row();
+}
+
+template <typename T, size_t P>
+void run_shape(bench::Reporter&          rep,
+               bench::BenchConfig const& cfg,
+               cav::WorkloadShape const& shape,
+               std::string const&        name) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto offsets = make_replay_calls(shape, cfg.tot_elems, rng);
+    auto keys    = make_replay_keys<T>(shape, offsets.back(), rng);
+    auto sizes   = shape.sizes;
+    std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+    rep.begin_row(name, std::string("replay"), sizes[sizes.size() / 2]);
+    if (P <= sizeof(T))
+        return run_row(rep, cfg, keys, offsets, [](T const& a) { return a; });
+
+    auto origin = std::vector<Pod<T, P>>(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        origin[i] = Pod<T, P>{keys[i], {}};
+    run_row(rep, cfg, origin, offsets, [](Pod<T, P> const& a) { return a.elem; });
+}
+
+/// @brief Runs the shape with T keys in values of the first size in 8, 16, ..., 256 bytes not
+/// smaller than the recorded one (or the keys alone if they are as large).
+template <typename T>
+void run_key(bench::Reporter&          rep,
+             bench::BenchConfig const& cfg,
+             cav::WorkloadShape const& shape,
+             std::string const&        name) {
+    size_t vs = shape.val_size;
+    if (vs <= sizeof(T))
+        return run_shape<T, sizeof(T)>(rep, cfg, shape, name);
+    if (vs <= 8)
+        return run_shape<T, 8>(rep, cfg, shape, name);
+    if (vs <= 16)
+        return run_shape<T, 16>(rep, cfg, shape, name);
+    if (vs <= 32)
+        return run_shape<T, 32>(rep, cfg, shape, name);
+    if (vs <= 64)
+        return run_shape<T, 64>(rep, cfg, shape, name);
+    if (vs <= 128)
+        return run_shape<T, 128>(rep, cfg, shape, name);
+    run_shape<T, 256>(rep, cfg, shape, name);
+}
+
+/// @brief Unsigned keys of at least `n_bytes` bytes, for the shapes with other key types (their
+/// histograms are of the to_uint mapping, so the radix sorts see the same digits).
+void run_other(bench::Reporter&          rep,
+               bench::BenchConfig const& cfg,
+               cav::WorkloadShape const& shape,
+               std::string const&        name) {
+    size_t n_bytes = shape.byte_hist.size();
+    if (n_bytes <= 1)
+        return run_key<uint8_t>(rep, cfg, shape, name);
+    if (n_bytes <= 2)
+        return run_key<uint16_t>(rep, cfg, shape, name);
+    if (n_bytes <= 4)
+        return run_key<uint32_t>(rep, cfg, shape, name);
+    if (n_bytes <= 8)
+        return run_key<uint64_t>(rep, cfg, shape, name);
+    fmt::print(stderr, "skipping {}: keys of more than 8 bytes are not replayed\n", name);
+}
+
+void run_workload(bench::Reporter&          rep,
+                  bench::BenchConfig const& cfg,
+                  cav::WorkloadShape const& shape) {
+    auto name = fmt::format("{}{}_{}B", shape.key_kind, 8 * shape.key_size, shape.val_size);
+    if (shape.sizes.empty()) {
+        fmt::print(stderr, "skipping {}: no call sampled\n", name);
+        return;
+    }
+    switch (shape.key_kind * 100 + shape.key_size) {
+    case 'u' * 100 + 1:
+        return run_key<uint8_t>(rep, cfg, shape, name);
+    case 'u' * 100 + 2:
+        return run_key<uint16_t>(rep, cfg, shape, name);
+    case 'u' * 100 + 4:
+        return run_key<uint32_t>(rep, cfg, shape, name);
+    case 'u' * 100 + 8:
+        return run_key<uint64_t>(rep, cfg, shape, name);
+    case 'i' * 100 + 1:
+        return run_key<int8_t>(rep, cfg, shape, name);
+    case 'i' * 100 + 2:
+        return run_key<int16_t>(rep, cfg, shape, name);
+    case 'i' * 100 + 4:
+        return run_key<int32_t>(rep, cfg, shape, name);
+    case 'i' * 100 + 8:
+        return run_key<int64_t>(rep, cfg, shape, name);
+    case 'f' * 100 + 4:
+        return run_key<float>(rep, cfg, shape, name);
+    case 'f' * 100 + 8:
+        return run_key<double>(rep, cfg, shape, name);
+    default:
+        return run_other(rep, cfg, shape, name);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char const** argv) {
+    if (argc < 2 || argv[1][0] == '-') {
+        fmt::print(stderr, "usage: {} WORKLOAD [options]\n", argv[0]);
+        bench::print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto workload = cav::WorkloadCapture();
+    if (!workload.load(argv[1])) {
+        fmt::print(stderr, "error: cannot read a workload from {}\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    auto args = std::vector<char const*>{argv[0]};
+    args.insert(args.end(), argv + 2, argv + argc);
+    auto cfg   = bench::parse_args(static_cast<int>(args.size()), args.data());
+    auto algos = std::vector<std::string>{"cav-sort", "lsd-rdx", "msd-rdx", "std-sort"};
+
+    bench::Reporter rep(cfg, "replay", algos);
+
+    for (cav::WorkloadShape const& shape : workload.shapes)
+        run_workload(rep, cfg, shape);
+
+    return rep.failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,213 +1,210 @@
 // SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
 // SPDX-License-Identifier: MIT
 
+// Sorting benchmark: each row sorts consecutive segments of about `length` elements drawn from a
+// seeded input distribution, and reports the ns per element of each algorithm (median of the
+// repetitions; p10 and p90 too in JSON/CSV). Run with --help for the options.
+
 #include "sort.hpp"
 
 #include <fmt/core.h>
-#include <fmt/ranges.h>
 
 #include <algorithm>
-#include <chrono>
 #include <cstdlib>
+#include <random>
 #include <vector>
 
 #include "ClassType.hpp"
 #include "Span.hpp"
-#include "limits.hpp"
-
-template <typename T, typename U>
-__attribute__((noinline)) void sort_sequence(T&&                     sorter,
-                                             std::vector<U>&         seq,
-                                             std::vector<int> const& offsets) {
-    for (size_t o = 0; o < offsets.size() - 1; ++o) {
-        auto span = cav::make_span(seq.data() + offsets[o], seq.data() + offsets[o + 1]);
-        sorter(span);
-    }
-}
-
-template <typename T, size_t N, typename K>
-void run_test_loop(char const (&name)[N],
-                   cav::Sorter<>&        sorter,
-                   std::vector<T> const& origin,
-                   int                   sub_size,
-                   int                   tot_elems,
-                   K                     key) {
-
-    double duration_sec  = 0;
-    double duration0_sec = 0;
-    double duration1_sec = 0;
-    double duration2_sec = 0;
-    double duration3_sec = 0;
-    double duration4_sec = 0;
-    auto   out_buff      = std::vector<T>(origin.size());
-    for (int i = 0; i < 1; ++i) {
-        auto seq0 = origin;
-        auto seq1 = origin;
-        auto seq2 = origin;
-        auto seq3 = origin;
-        auto seq4 = origin;
-        auto seq5 = origin;
-
-        auto idis    = [&] { return sub_size - sub_size / 8 + rand() % (sub_size / 4); };
-        auto offsets = std::vector<int>();
-        for (size_t offset = 0; offset < seq0.size(); offset += idis())
-            offsets.push_back(offset);
-        if (offsets.back() != static_cast<int>(seq0.size()))
-            offsets.push_back(seq0.size());
-
-        auto t0 = std::chrono::high_resolution_clock::now();
-        sort_sequence([&](cav::Span<T*> c) { sorter.net_sort(c, key); }, seq0, offsets);
-        auto t1 = std::chrono::high_resolution_clock::now();
-        sort_sequence([&](cav::Span<T*> c) { sorter.radix_sort_lsd(c, key); }, seq1, offsets);
-        auto t2 = std::chrono::high_resolution_clock::now();
-        sort_sequence([&](cav::Span<T*> c) { sorter.radix_sort_msd(c, key); }, seq2, offsets);
-        auto t3 = std::chrono::high_resolution_clock::now();
-        sort_sequence([&](cav::Span<T*> c) { sorter.sort(c, key); }, seq3, offsets);
-        auto t4 = std::chrono::high_resolution_clock::now();
-        sort_sequence(
-            [&](cav::Span<T*> c) { std::sort(c.begin(), c.end(), cav::sort::make_comp_wrap(key)); },
-            seq4,
-            offsets);
-        auto t5 = std::chrono::high_resolution_clock::now();
-        sort_sequence(
-            [&](cav::Span<T*> c) { std::sort(c.begin(), c.end(), cav::sort::make_comp_wrap(key)); },
-            seq4,
-            offsets);
-        auto t6 = std::chrono::high_resolution_clock::now();
-
-        duration_sec += std::chrono::duration<double>(t1 - t0).count();
-        duration0_sec += std::chrono::duration<double>(t2 - t1).count();
-        duration1_sec += std::chrono::duration<double>(t3 - t2).count();
-        duration2_sec += std::chrono::duration<double>(t4 - t3).count();
-        duration3_sec += std::chrono::duration<double>(t5 - t4).count();
-        duration4_sec += std::chrono::duration<double>(t6 - t5).count();
-#ifndef NDEBUG
-        for (size_t i = 0; i < seq4.size(); ++i) {
-            assert(key(seq0[i]) == key(seq4[i]));
-            assert(key(seq1[i]) == key(seq4[i]));
-            assert(key(seq2[i]) == key(seq4[i]));
-            assert(key(seq3[i]) == key(seq4[i]));
-        }
-#endif
+#include "baselines.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = cav::bench;
+
+namespace {
+
+template <typename T, typename K, typename V>
+struct BaselineRunner {
+    bench::Reporter&           rep;
+    bench::BenchConfig const&  cfg;
+    std::vector<T> const&      origin;
+    std::vector<size_t> const& offsets;
+    K                          key;
+    V                          check;
+    size_t                     col;
+
+    template <typename B>
+    void operator()(B baseline) {
+        auto algo = [&](cav::Span<T*> c) { baseline(c, key); };
+        rep.add(col++, bench::measure(cfg, origin, offsets, algo, check));
     }
-
-    fmt::print(" {:10.0f} {:10.0f} {:10.0f} {:10.0f} {:10.0f} {:10.0f}\n",
-               1e9 * duration_sec / cav::size(origin),
-               1e9 * duration0_sec / cav::size(origin),
-               1e9 * duration1_sec / cav::size(origin),
-               1e9 * duration2_sec / cav::size(origin),
-               1e9 * duration3_sec / cav::size(origin),
-               1e9 * duration4_sec / cav::size(origin));
-}
-
-template <typename T, size_t N>
-void run_test(char const (&name)[N], cav::Sorter<>& sorter, int sub_size, int tot_elems) {
-    T    min = -std::sqrt(-(T{1} + cav::limits<T>::min()));
-    T    max = std::sqrt(cav::limits<T>::max());
-    auto dis = [min, max]() {
-        double rand_val = static_cast<double>(rand()) / static_cast<double>(RAND_MAX);
-        return min + rand_val * (max - min);
+};
+
+template <typename T, typename K>
+void run_row(bench::Reporter&           rep,
+             bench::BenchConfig const&  cfg,
+             std::vector<T> const&      origin,
+             std::vector<size_t> const& offsets,
+             K                          key) {
+    // Every algorithm must give the same keys sequence of a stable sort of each segment
+    auto expected = origin;
+    for (size_t o = 0; o + 1 < offsets.size(); ++o)
+        std::stable_sort(expected.begin() + offsets[o],
+                         expected.begin() + offsets[o + 1],
+                         cav::sort::make_comp_wrap(key));
+    auto matches = [&](std::vector<T> const& seq) {
+        for (size_t i = 0; i < seq.size(); ++i)
+            if (key(seq[i]) != key(expected[i]))
+                return false;
+        return true;
     };
 
-    auto origin = std::vector<T>(tot_elems);
-    for (int i = 0; i < tot_elems; ++i)
-        origin[i] = static_cast<T>(dis());
-
-    fmt::print("{:9} {:9} {:9} [{:7.1},{:6.1}]",
-               name,
-               sub_size,
-               tot_elems / sub_size,
-               double(min),
-               double(max));
-    run_test_loop(name, sorter, origin, sub_size, tot_elems, [](T const& a) { return a; });
+    using Sorter  = bench::BenchSorter;
+    auto net_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.net_sort(c, key); };
+    auto lsd_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.radix_sort_lsd(c, key); };
+    auto msd_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.radix_sort_msd(c, key); };
+    auto cav_sort = [&](Sorter& sorter, cav::Span<T*> c) { sorter.sort(c, key); };
+    rep.add(0, bench::measure_sorter(cfg, origin, offsets, net_sort, matches));
+    rep.add(1, bench::measure_sorter(cfg, origin, offsets, lsd_sort, matches));
+    rep.add(2, bench::measure_sorter(cfg, origin, offsets, msd_sort, matches));
+    rep.add(3, bench::measure_sorter(cfg, origin, offsets, cav_sort, matches));
+    bench::for_each_baseline(BaselineRunner<T, K, decltype(matches)>{
+        rep, cfg, origin, offsets, key, matches, 4});
+    rep.end_row();
 }
 
-template <typename T, size_t P, size_t N>
-void run_test_fat(char const (&name)[N], cav::Sorter<>& sorter, int sub_size, int tot_elems) {
-    T    min = -std::sqrt(-(T{1} + cav::limits<T>::min()));
-    T    max = std::sqrt(cav::limits<T>::max());
-    auto dis = [min, max]() {
-        double rand_val = static_cast<double>(rand()) / static_cast<double>(RAND_MAX);
-        return min + rand_val * (max - min);
-    };
-
-    auto origin = std::vector<cav::ClassType<T, P>>(tot_elems);
-    for (int i = 0; i < tot_elems; ++i)
-        origin[i] = cav::ClassType<T, P>{static_cast<T>(dis())};
-
+template <typename T>
+void run_test(char const*               name,
+              bench::Reporter&          rep,
+              bench::BenchConfig const& cfg,
+              bench::Dist               dist,
+              size_t                    seg_size) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto origin  = bench::make_keys<T>(dist, cfg.tot_elems, rng);
+    auto offsets = bench::make_offsets(cfg.tot_elems, seg_size, rng);
+    rep.begin_row(name, dist, seg_size);
+    run_row(rep, cfg, origin, offsets, [](T const& a) { return a; });
+}
 
-    fmt::print("{:9} {:9} {:9} [{:7.1},{:6.1}]",
-               name,
-               sub_size,
-               tot_elems / sub_size,
-               double(min),
-               double(max));
-    run_test_loop(name, sorter, origin, sub_size, tot_elems, [](cav::ClassType<T, P> const& a) {
-        return T(a);
-    });
+template <typename T, size_t P>
+void run_test_fat(char const*               name,
+                  bench::Reporter&          rep,
+                  bench::BenchConfig const& cfg,
+                  bench::Dist               dist,
+                  size_t                    seg_size) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto keys    = bench::make_keys<T>(dist, cfg.tot_elems, rng);
+    auto offsets = bench::make_offsets(cfg.tot_elems, seg_size, rng);
+    auto origin  = std::vector<cav::ClassType<T, P>>();
+    origin.reserve(keys.size());
+    for (T k : keys)
+        origin.emplace_back(k);
+    rep.begin_row(name, dist, seg_size);
+    run_row(rep, cfg, origin, offsets, [](cav::ClassType<T, P> const& a) { return T(a); });
 }
 
-template <typename T, size_t N>
-void run_test_indirect(char const (&name)[N], cav::Sorter<>& sorter, int sub_size, int tot_elems) {
-    T    min = -std::sqrt(-(T{1} + cav::limits<T>::min()));
-    T    max = std::sqrt(cav::limits<T>::max());
-    auto dis = [min, max]() {
-        double rand_val = static_cast<double>(rand()) / static_cast<double>(RAND_MAX);
-        return min + rand_val * (max - min);
-    };
+/// @brief Trivially copyable records of P bytes keyed by their first field.
+template <typename T, size_t P>
+struct Pod {
+    T    elem;
+    char data[P - sizeof(T)];
+};
+
+template <typename T, size_t P>
+void run_test_pod(char const*               name,
+                  bench::Reporter&          rep,
+                  bench::BenchConfig const& cfg,
+                  bench::Dist               dist,
+                  size_t                    seg_size) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto keys    = bench::make_keys<T>(dist, cfg.tot_elems, rng);
+    auto offsets = bench::make_offsets(cfg.tot_elems, seg_size, rng);
+    auto origin  = std::vector<Pod<T, P>>(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        origin[i].elem = keys[i];
+    rep.begin_row(name, dist, seg_size);
+    run_row(rep, cfg, origin, offsets, [](Pod<T, P> const& a) { return a.elem; });
+}
 
-    auto order  = std::vector<T>(tot_elems);
-    auto origin = std::vector<T>(tot_elems);
-    for (int i = 0; i < tot_elems; ++i) {
-        order[i]  = static_cast<T>(dis());
-        origin[i] = i;
-    }
+template <typename T>
+void run_test_indirect(char const*               name,
+                       bench::Reporter&          rep,
+                       bench::BenchConfig const& cfg,
+                       bench::Dist               dist,
+                       size_t                    seg_size) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto order   = bench::make_keys<T>(dist, cfg.tot_elems, rng);
+    auto offsets = bench::make_offsets(cfg.tot_elems, seg_size, rng);
+    auto origin  = std::vector<uint32_t>(cfg.tot_elems);
+    for (size_t i = 0; i < origin.size(); ++i)
+        origin[i] = static_cast<uint32_t>(i);
+    rep.begin_row(name, dist, seg_size);
+    run_row(rep, cfg, origin, offsets, [&](uint32_t i) { return order[i]; });
+}
 
-    fmt::print("{:9} {:9} {:9} [{:7.1},{:6.1}]",
-               name,
-               sub_size,
-               tot_elems / sub_size,
-               double(min),
-               double(max));
-    run_test_loop(name, sorter, origin, sub_size, tot_elems, [&](T const& a) { return order[a]; });
+/// @brief Same as run_test_indirect through cav::indirect_key, which lets the radix passes prefetch
+/// the keys.
+template <typename T>
+void run_test_prefetch(char const*               name,
+                       bench::Reporter&          rep,
+                       bench::BenchConfig const& cfg,
+                       bench::Dist               dist,
+                       size_t                    seg_size) {
+    auto rng     = std::mt19937_64(cfg.seed);
+    auto order   = bench::make_keys<T>(dist, cfg.tot_elems, rng);
+    auto offsets = bench::make_offsets(cfg.tot_elems, seg_size, rng);
+    auto origin  = std::vector<uint32_t>(cfg.tot_elems);
+    for (size_t i = 0; i < origin.size(); ++i)
+        origin[i] = static_cast<uint32_t>(i);
+    rep.begin_row(name, dist, seg_size);
+    run_row(rep, cfg, origin, offsets, cav::indirect_key(order.data()));
 }
 
-#ifndef NDEBUG
-#define TOT_ELEMS 10000
-#else
-#define TOT_ELEMS 10000000
-#endif
+}  // namespace
+
 int main(int argc, char const** argv) {
-    auto args = cav::make_span(argv, argc);
-
-    auto sorter   = cav::Sorter<>();
-    int  sub_size = std::stoi(args[1]);
-
-    fmt::print("type         length   samples            range   net-sort    lsd-rdx    msd-rdx   "
-               "cav-sort   std-sort   ska-sort\n");
-    // natives
-    run_test<int8_t>("int8_t", sorter, sub_size, TOT_ELEMS);
-    run_test<int16_t>("int16_t", sorter, sub_size, TOT_ELEMS);
-    run_test<int32_t>("int32_t", sorter, sub_size, TOT_ELEMS);
-    run_test<int64_t>("int64_t", sorter, sub_size, TOT_ELEMS);
-    run_test<float>("float", sorter, sub_size, TOT_ELEMS);
-    run_test<double>("double", sorter, sub_size, TOT_ELEMS);
-
-    //// struct like
-    run_test_fat<float, 8>("flt_8B", sorter, sub_size, TOT_ELEMS);
-    run_test_fat<float, 16>("flt_16B", sorter, sub_size, TOT_ELEMS);
-    run_test_fat<float, 32>("flt_32B", sorter, sub_size, TOT_ELEMS);
-    run_test_fat<float, 64>("flt_64B", sorter, sub_size, TOT_ELEMS);
-
-    run_test_fat<double, 16>("dbl_16B", sorter, sub_size, TOT_ELEMS);
-    run_test_fat<double, 32>("dbl_32B", sorter, sub_size, TOT_ELEMS);
-    run_test_fat<double, 64>("dbl_64B", sorter, sub_size, TOT_ELEMS);
-
-    // indirect
-    run_test_indirect<int32_t>("i32_ind", sorter, sub_size, TOT_ELEMS);
-    run_test_indirect<int64_t>("i64_ind", sorter, sub_size, TOT_ELEMS);
-    run_test_indirect<float>("flt_ind", sorter, sub_size, TOT_ELEMS);
-    run_test_indirect<double>("dbl_ind", sorter, sub_size, TOT_ELEMS);
-
-    return EXIT_SUCCESS;
+    auto cfg    = bench::parse_args(argc, argv);
+    auto algos  = std::vector<std::string>{"net-sort", "lsd-rdx", "msd-rdx", "cav-sort"};
+    for (auto const& name : bench::baseline_names())
+        algos.push_back(name);
+
+    bench::Reporter rep(cfg, "sort", algos);
+
+    for (bench::Dist dist : cfg.dists)
+        for (size_t seg : cfg.segments) {
+            // natives
+            run_test<int8_t>("int8_t", rep, cfg, dist, seg);
+            run_test<int16_t>("int16_t", rep, cfg, dist, seg);
+            run_test<int32_t>("int32_t", rep, cfg, dist, seg);
+            run_test<int64_t>("int64_t", rep, cfg, dist, seg);
+            run_test<float>("float", rep, cfg, dist, seg);
+            run_test<double>("double", rep, cfg, dist, seg);
+
+            // struct like
+            run_test_fat<float, 8>("flt_8B", rep, cfg, dist, seg);
+            run_test_fat<float, 16>("flt_16B", rep, cfg, dist, seg);
+            run_test_fat<float, 32>("flt_32B", rep, cfg, dist, seg);
+            run_test_fat<float, 64>("flt_64B", rep, cfg, dist, seg);
+
+            run_test_fat<double, 16>("dbl_16B", rep, cfg, dist, seg);
+            run_test_fat<double, 32>("dbl_32B", rep, cfg, dist, seg);
+            run_test_fat<double, 64>("dbl_64B", rep, cfg, dist, seg);
+
+            // trivially copyable records over a cache line
+            run_test_pod<double, 128>("dbl_128P", rep, cfg, dist, seg);
+
+            // indirect
+            run_test_indirect<int32_t>("i32_ind", rep, cfg, dist, seg);
+            run_test_indirect<int64_t>("i64_ind", rep, cfg, dist, seg);
+            run_test_indirect<float>("flt_ind", rep, cfg, dist, seg);
+            run_test_indirect<double>("dbl_ind", rep, cfg, dist, seg);
+
+            // indirect, prefetched
+            run_test_prefetch<int32_t>("i32_ipf", rep, cfg, dist, seg);
+            run_test_prefetch<int64_t>("i64_ipf", rep, cfg, dist, seg);
+            run_test_prefetch<float>("flt_ipf", rep, cfg, dist, seg);
+            run_test_prefetch<double>("dbl_ipf", rep, cfg, dist, seg);
+        }
+
+    return rep.failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "adaptive_sort.hpp"
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+#include "../src/ClassType.hpp"
+#include "Span.hpp"
+
+namespace cav {
+
+TEST_CASE("adaptive sort int") {
+    auto arr    = std::vector<int>(10000);
+    auto sorter = AdaptiveSorter<>();
+    for (size_t i = 0; i < 30; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (int& elem : subseq)
+                elem = rand() - RAND_MAX / 2;
+            REQUIRE_NOTHROW(sorter.sort(subseq));
+            CHECK(is_sorted(subseq));
+        }
+    }
+}
+
+TEST_CASE("adaptive sort ClassType<double>") {
+    auto arr    = std::vector<ClassType<double>>(10000);
+    auto sorter = AdaptiveSorter<>(2);
+    auto key    = [](ClassType<double> const& c) { return static_cast<double>(c); };
+    for (size_t i = 0; i < 30; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (auto& elem : subseq)
+                elem = ClassType<double>(rand() * 0.5 - RAND_MAX / 4);
+            REQUIRE_NOTHROW(sorter.sort(subseq, key));
+            CHECK(is_sorted(subseq, key));
+        }
+    }
+}
+
+TEST_CASE("adaptive sort statistics") {
+    auto arr    = std::vector<uint16_t>(100);
+    auto sorter = AdaptiveSorter<>();
+    for (size_t i = 0; i < 2000; ++i) {
+        for (uint16_t& elem : arr)
+            elem = static_cast<uint16_t>(rand());
+        sorter.sort(arr);
+    }
+    CHECK(is_sorted(arr));
+
+    auto const& shape   = sorter.shape_stats(sizeof(uint16_t), sizeof(uint16_t), arr.size());
+    uint32_t    samples = 0;
+    for (auto const& as : shape.algos) {
+        CHECK(as.samples > 0);
+        CHECK(shape.algos[static_cast<uint8_t>(shape.best)].ns_per_elem <= as.ns_per_elem);
+        samples += as.samples;
+    }
+    CHECK(shape.calls == 2000);
+    CHECK(samples < 1000);  // only exploration calls are timed
+
+    CHECK(sorter.shape_stats(2, 2, 16).calls == 0);
+    sorter.reset_stats();
+    CHECK(sorter.shape_stats(sizeof(uint16_t), sizeof(uint16_t), arr.size()).calls == 0);
+}
+
+}  // namespace cav
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "counting_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+#include "sort.hpp"
+
+namespace cav {
+
+TEST_CASE("CountingAllocator counts allocations and peak bytes") {
+    auto counters = AllocCounters();
+    {
+        auto alc = CountingAllocator<int>(counters);
+        auto vec = std::vector<int, CountingAllocator<int>>(alc);
+        vec.reserve(100);
+        CHECK(counters.allocs == 1);
+        CHECK(counters.live_bytes == 100 * sizeof(int));
+        vec.reserve(1000);
+        CHECK(counters.allocs == 2);
+        CHECK(counters.deallocs == 1);
+        CHECK(counters.live_bytes == 1000 * sizeof(int));
+        CHECK(counters.peak_bytes == 1100 * sizeof(int));  // both alive while moving
+        CHECK(counters.alloc_bytes == 1100 * sizeof(int));
+    }
+    CHECK(counters.deallocs == 2);
+    CHECK(counters.live_bytes == 0);
+
+    counters.reset();
+    CHECK(counters.allocs == 0);
+    CHECK(counters.peak_bytes == 0);
+    CHECK(counters.minor_faults() >= 0);
+}
+
+TEST_CASE("CountingAllocator rebound copies share the counters") {
+    auto counters = AllocCounters();
+    auto alc      = CountingAllocator<char>(counters);
+    auto alc_int  = CountingAllocator<int>(alc);
+    CHECK(&alc_int.counters() == &counters);
+    CHECK(alc_int == alc);
+    CHECK(alc_int != CountingAllocator<int>());
+
+    int* ptr = alc_int.allocate(10);
+    CHECK(counters.live_bytes == 10 * sizeof(int));
+    alc_int.deallocate(ptr, 10);
+    CHECK(counters.live_bytes == 0);
+}
+
+TEST_CASE("CountingAllocator in Sorter") {
+    auto sorter = Sorter<uint32_t, CountingAllocator<char>>();
+    auto arr    = std::vector<uint64_t>(1000);
+    for (uint64_t& elem : arr)
+        elem = static_cast<uint64_t>(rand());
+
+    AllocCounters& counters = sorter.get_allocator().counters();
+    CHECK(&counters == &default_alloc_counters());
+    counters.reset();
+    sorter.radix_sort_lsd(arr);
+    CHECK(is_sorted(arr));
+    CHECK(counters.allocs == 1);
+    CHECK(counters.peak_bytes >= 1000 * sizeof(uint64_t));
+
+    sorter.radix_sort_lsd(arr);
+    CHECK(counters.allocs == 1);  // the buffer is reused
+}
+
+}  // namespace cav
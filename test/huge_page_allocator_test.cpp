@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "huge_page_allocator.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "counting_allocator.hpp"
+#include "sort.hpp"
+
+namespace cav {
+
+TEST_CASE("HugePageAllocator alignment") {
+    auto     alc     = HugePageAllocator<char>();
+    size_t   sizes[] = {1, 63, 1000, size_t{2} << 20U, (size_t{5} << 20U) + 3};
+    uint64_t aligned = huge_page_counters().aligned;
+    for (size_t sz : sizes) {
+        char* ptr = alc.allocate(sz);
+        CHECK(reinterpret_cast<uintptr_t>(ptr) % 64 == 0);
+#ifdef __linux__
+        if (sz >= (size_t{2} << 20U))
+            CHECK(reinterpret_cast<uintptr_t>(ptr) % (size_t{2} << 20U) == 0);
+#endif
+        std::memset(ptr, 0xAB, sz);
+        alc.deallocate(ptr, sz);
+    }
+#ifdef __linux__
+    CHECK(huge_page_counters().aligned == aligned + 3);
+#endif
+    alc.deallocate(nullptr, 0);
+}
+
+TEST_CASE("HugePageAllocator parallel prefault") {
+    auto   alc = HugePageAllocator<uint64_t>(4);
+    size_t n   = (size_t{160} << 20U) / sizeof(uint64_t);  // 2 threads of 64 MiB at least
+    CHECK(alc.prefault_threads() == 4);
+    uint64_t* ptr = alc.allocate(n);
+    for (size_t i = 0; i < n; i += 4096)
+        CHECK(ptr[i] == 0);
+    ptr[n - 1] = 1;
+    alc.deallocate(ptr, n);
+
+    auto rebound = HugePageAllocator<char>(alc);
+    CHECK(rebound.prefault_threads() == 4);
+    CHECK(rebound == alc);
+}
+
+TEST_CASE("HugePageAllocator in Sorter") {
+    auto sorter = Sorter<uint32_t, CountingAllocator<char, HugePageAllocator<char>>>();
+    auto arr    = std::vector<uint64_t>(1U << 19U);  // 4 MiB buffer
+    for (uint64_t& elem : arr)
+        elem = (static_cast<uint64_t>(rand()) << 32U) ^ static_cast<uint64_t>(rand());
+    sorter.radix_sort_lsd(arr);
+    CHECK(is_sorted(arr));
+    CHECK(sorter.get_allocator().counters().live_bytes == arr.size() * sizeof(uint64_t));
+
+    std::reverse(arr.begin(), arr.end());
+    sorter.sort(arr);
+    CHECK(is_sorted(arr));
+}
+
+}  // namespace cav
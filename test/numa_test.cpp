@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "numa.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cav {
+
+TEST_CASE("parse_id_list") {
+    auto ids = std::vector<unsigned>();
+    CHECK(parse_id_list("0-3,8,10-11\n", ids));
+    CHECK(ids == std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11});
+    CHECK(parse_id_list("5", ids));
+    CHECK(ids == std::vector<unsigned>{5});
+    CHECK(parse_id_list("", ids));
+    CHECK(ids.empty());
+    CHECK_FALSE(parse_id_list("3-1", ids));
+    CHECK_FALSE(parse_id_list("a,b", ids));
+    CHECK_FALSE(parse_id_list("1,-2", ids));
+}
+
+#ifdef __linux__
+TEST_CASE("NumaTopology from a sysfs tree") {
+    auto root = std::string("/tmp/cav_numa_test_") + std::to_string(getpid());
+    auto put  = [](std::string const& path, char const* text) {
+        std::ofstream out(path);
+        out << text;
+    };
+    mkdir(root.c_str(), 0700);
+    mkdir((root + "/node0").c_str(), 0700);
+    mkdir((root + "/node1").c_str(), 0700);
+    put(root + "/online", "0-1\n");
+    put(root + "/node0/cpulist", "0-1,4-5\n");
+    put(root + "/node1/cpulist", "2-3,6-7\n");
+
+    NumaTopology topo = NumaTopology::load(root);
+    REQUIRE(topo.nodes.size() == 2);
+    CHECK_FALSE(topo.single_node());
+    CHECK(topo.nodes[1].id == 1);
+    CHECK(topo.nodes[1].cpus == std::vector<unsigned>{2, 3, 6, 7});
+    REQUIRE(topo.node_of_cpu(5) != nullptr);
+    CHECK(topo.node_of_cpu(5)->id == 0);
+    CHECK(topo.node_of_cpu(6)->id == 1);
+    CHECK(topo.node_of_cpu(8) == nullptr);
+
+    for (char const* file : {"/online", "/node0/cpulist", "/node1/cpulist"})
+        std::remove((root + file).c_str());
+    for (char const* dir : {"/node0", "/node1", ""})
+        rmdir((root + dir).c_str());
+
+    CHECK(NumaTopology::load(root).single_node());  // no sysfs: no nodes
+}
+#endif
+
+TEST_CASE("NumaTopology of the host") {
+    NumaTopology const& topo = numa_topology();
+    for (NumaNode const& node : topo.nodes) {
+        CHECK_FALSE(node.cpus.empty());
+        CHECK(topo.node_of_cpu(node.cpus.front()) == &node);
+    }
+    if (topo.nodes.empty())
+        return;
+
+    NumaNode const* node = topo.current_node();
+    REQUIRE(node != nullptr);
+    auto cpus   = node->cpus;
+    bool pinned = false;
+    auto worker = std::thread([&] {
+        pinned = pin_current_thread(cpus) && numa_topology().current_node() == node;
+    });
+    worker.join();
+    CHECK(pinned);
+}
+
+}  // namespace cav
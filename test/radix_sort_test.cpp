@@ -9,10 +9,28 @@
 
 #include <doctest/doctest.h>
 
+#include <algorithm>
+
 #include "Span.hpp"
 #include "../src/ClassType.hpp"
 
 namespace cav {
+namespace {
+    /// 40-bit timestamp packed in 64 bits, with no comparison operators
+    struct Stamp40 {
+        uint64_t ticks;
+    };
+}  // namespace
+
+template <>
+struct key_traits<Stamp40> {
+    using ukey_type              = uint64_t;
+    static constexpr size_t bits = 40;
+
+    static uint64_t to_uint(Stamp40 s) noexcept {
+        return s.ticks;
+    }
+};
 
 TEST_CASE("radix_sort_lsd int") {
     auto arr  = std::vector<int>(10000);
@@ -182,4 +200,187 @@ TEST_CASE("radix_sort_msd double") {
     }
 }
 
-}  // namespace cav
\ No newline at end of file
+namespace {
+#ifdef __SIZEOF_INT128__
+    uint128_t rand_u128() {
+        return (static_cast<uint128_t>(rand()) << 96U) | (static_cast<uint128_t>(rand()) << 64U) |
+               rand();
+    }
+#endif
+
+    /// 20-byte hash-like key with a constant 6-byte prefix
+    std::array<uint8_t, 20> rand_hash() {
+        auto k = std::array<uint8_t, 20>{{0xCA, 0xFE, 0xBA, 0xBE, 0x00, 0x01}};
+        for (size_t b = 6; b < k.size(); ++b)
+            k[b] = static_cast<uint8_t>(rand() % (b < 10 ? 4 : 256));
+        return k;
+    }
+}  // namespace
+
+#ifdef __SIZEOF_INT128__
+TEST_CASE("radix_sort_lsd 128-bit keys") {
+    auto arr  = std::vector<int128_t>(10000);
+    auto buff = std::vector<int128_t>(10000);
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 10000; s = s * 17 / 3) {
+            auto subseq = make_span(arr.data(), s);
+            for (int128_t& elem : subseq)
+                elem = static_cast<int128_t>(rand_u128()) >> 20U;
+            REQUIRE_NOTHROW(radix_sort_lsd<int>(subseq, buff));
+            CHECK(is_sorted(subseq));
+        }
+    }
+}
+
+TEST_CASE("radix_sort_msd 128-bit keys") {
+    auto arr  = std::vector<uint128_t>(10000);
+    auto buff = std::vector<uint128_t>(10000);
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 10000; s = s * 17 / 3) {
+            auto subseq = make_span(arr.data(), s);
+            for (uint128_t& elem : subseq)
+                elem = rand_u128() >> (i * 8U);
+            REQUIRE_NOTHROW(radix_sort_msd<int>(subseq, buff));
+            CHECK(is_sorted(subseq));
+        }
+    }
+}
+#endif
+
+TEST_CASE("radix sort wide keys") {
+    auto harr  = std::vector<std::array<uint8_t, 20>>(10000);
+    auto hbuff = std::vector<std::array<uint8_t, 20>>(10000);
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 10000; s = s * 17 / 3) {
+            auto hsubseq = make_span(harr.data(), s);
+            for (auto& elem : hsubseq)
+                elem = rand_hash();
+            REQUIRE_NOTHROW(radix_sort_lsd<int>(hsubseq, hbuff));
+            CHECK(is_sorted(hsubseq));
+
+            for (auto& elem : hsubseq)
+                elem = rand_hash();
+            REQUIRE_NOTHROW(radix_sort_msd<int>(hsubseq, hbuff));
+            CHECK(is_sorted(hsubseq));
+        }
+    }
+}
+
+TEST_CASE("radix sort keys of 256 bytes or more") {
+    using Key300 = std::array<uint8_t, 300>;
+    auto arr     = std::vector<Key300>(2000);
+    auto buff    = std::vector<Key300>(2000);
+    for (size_t s = 2; s <= 2000; s = s * 17 / 3) {
+        auto subseq = make_span(arr.data(), s);
+        for (Key300& elem : subseq) {
+            elem      = Key300{};
+            elem[0]   = static_cast<uint8_t>(rand() % 3);  // most significant
+            elem[44]  = static_cast<uint8_t>(rand() % 3);  // byte 255
+            elem[299] = static_cast<uint8_t>(rand() % 256);
+        }
+        REQUIRE_NOTHROW(radix_sort_lsd<int>(subseq, buff));
+        CHECK(is_sorted(subseq));
+
+        std::reverse(subseq.begin(), subseq.end());
+        REQUIRE_NOTHROW(radix_sort_msd<int>(subseq, buff));
+        CHECK(is_sorted(subseq));
+    }
+}
+
+TEST_CASE("radix sort custom key bits") {
+    auto arr  = std::vector<Stamp40>(10000);
+    auto buff = std::vector<Stamp40>(10000);
+    auto ukey = [](Stamp40 s) { return to_uint(s); };
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 10000; s = s * 17 / 3) {
+            auto subseq = make_span(arr.data(), s);
+
+            for (Stamp40& elem : subseq)
+                elem = Stamp40{(static_cast<uint64_t>(rand()) << 9U) ^ rand()};
+            REQUIRE_NOTHROW(radix_sort_lsd<int>(subseq, buff));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (Stamp40& elem : subseq)
+                elem = Stamp40{(static_cast<uint64_t>(rand()) << 9U) ^ rand()};
+            REQUIRE_NOTHROW(radix_sort_msd<int>(subseq, buff));
+            CHECK(is_sorted(subseq, ukey));
+        }
+    }
+}
+
+TEST_CASE("radix sort bit range") {
+    auto arr   = std::vector<uint64_t>(10000);
+    auto buff  = std::vector<uint64_t>(10000);
+    auto range = bit_range<12, 44>();
+    auto ukey  = [](uint64_t x) { return (x >> 12U) & 0xFFFFFFFFU; };
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 10000; s = s * 17 / 3) {
+            auto subseq = make_span(arr.data(), s);
+
+            for (uint64_t& elem : subseq)
+                elem = (static_cast<uint64_t>(rand()) << 33U) ^
+                       (static_cast<uint64_t>(rand()) >> i);
+            REQUIRE_NOTHROW(radix_sort_lsd<int>(subseq, buff, range));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (uint64_t& elem : subseq)
+                elem = (static_cast<uint64_t>(rand()) << 33U) ^
+                       (static_cast<uint64_t>(rand()) >> i);
+            REQUIRE_NOTHROW(radix_sort_msd<int>(subseq, buff, range));
+            CHECK(is_sorted(subseq, ukey));
+        }
+    }
+}
+
+namespace {
+    /// Indirect key counting the prefetches the radix passes issue
+    struct CountingPrefetchKey {
+        IndirectKey<double*> ind;
+        size_t*              prefetches;
+
+        double operator()(uint32_t i) const {
+            return ind(i);
+        }
+
+        void prefetch(uint32_t i) const {
+            ++*prefetches;
+            ind.prefetch(i);
+        }
+    };
+}  // namespace
+
+TEST_CASE("radix sort indirect keys prefetch") {
+    auto scores = std::vector<double>(10000);
+    auto idxs   = std::vector<uint32_t>(10000);
+    auto buff   = std::vector<uint32_t>(10000);
+    for (double& s : scores)
+        s = rand() * 0.25 - RAND_MAX / 8;
+    auto key = indirect_key(scores.data());
+    CHECK(key(3) == scores[3]);
+    CHECK(sort::has_prefetch<decltype(key), uint32_t>::value);
+    CHECK_FALSE(sort::has_prefetch<IdentityFtor, uint32_t>::value);
+
+    size_t prefetches = 0;
+    auto   counting   = CountingPrefetchKey{key, &prefetches};
+    for (size_t s = 2; s <= 10000; s = s * 17 / 3) {
+        auto subseq = make_span(idxs.data(), s);
+        for (uint32_t i = 0; i < s; ++i)
+            subseq[i] = static_cast<uint32_t>(s - 1 - i);
+        REQUIRE_NOTHROW(radix_sort_lsd<uint32_t>(subseq, buff, key));
+        CHECK(is_sorted(subseq, key));
+
+        for (uint32_t i = 0; i < s; ++i)
+            subseq[i] = static_cast<uint32_t>((i * 7919U) % s);
+        prefetches = 0;
+        REQUIRE_NOTHROW(radix_sort_msd<uint32_t>(subseq, buff, counting));
+        CHECK(is_sorted(subseq, key));
+        CHECK(prefetches > 0);
+    }
+
+    auto projected = indirect_key(scores.data(), [](double d) { return -d; });
+    auto subseq    = make_span(idxs.data(), 5000);
+    REQUIRE_NOTHROW(radix_sort_lsd<uint32_t>(subseq, buff, projected));
+    CHECK(is_sorted(subseq, projected));
+}
+
+}  // namespace cav
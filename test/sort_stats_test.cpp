@@ -0,0 +1,224 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "sort_stats.hpp"
+
+#include <doctest/doctest.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/ClassType.hpp"
+#include "Span.hpp"
+#include "sort.hpp"
+
+namespace cav {
+
+using StatSorter = Sorter<uint32_t, std::allocator<char>, SortStats>;
+
+TEST_CASE("NoSortStats takes no space") {
+    CHECK(sizeof(Sorter<>) <= 3 * sizeof(void*));  // buffer, capacity and high-water mark
+    CHECK(sizeof(Sorter<uint64_t>) <= 3 * sizeof(void*));
+}
+
+TEST_CASE("SortStats radix_sort_lsd") {
+    auto arr    = std::vector<int32_t>(1000);
+    auto sorter = StatSorter();
+    for (int32_t& elem : arr)
+        elem = rand() % 1000;  // the two most significant bytes are constant
+    sorter.radix_sort_lsd(arr);
+    CHECK(is_sorted(arr));
+
+    auto const& st = sorter.stats();
+    CHECK(st.of(SortAlgo::radix_lsd).calls == 1);
+    CHECK(st.of(SortAlgo::radix_lsd).elems == 1000);
+    CHECK(st.of(SortAlgo::radix_msd).calls == 0);
+    CHECK(st.passes_run == 2);
+    CHECK(st.passes_skipped == 2);
+    CHECK(st.elems_moved == 2000);
+    CHECK(st.bytes_moved == 2000 * sizeof(int32_t));
+    CHECK(st.key_calls == 3000);  // histograms + 2 scatter passes
+    CHECK(st.buff_reallocs == 1);
+    CHECK(st.buff_bytes == 1000 * sizeof(int32_t));
+
+    sorter.radix_sort_lsd(arr);
+    CHECK(st.buff_reallocs == 1);
+    CHECK(st.buff_peak_bytes == 1000 * sizeof(int32_t));
+
+    arr.resize(2000);
+    sorter.radix_sort_lsd(arr);
+    CHECK(st.buff_reallocs == 2);
+    CHECK(st.buff_bytes == 2000 * sizeof(int32_t));
+    CHECK(st.buff_peak_bytes == 2000 * sizeof(int32_t));
+    CHECK(st.buff_alloc_bytes == 3000 * sizeof(int32_t));
+
+    sorter.stats().reset();
+    CHECK(st.of(SortAlgo::radix_lsd).calls == 0);
+    CHECK(st.key_calls == 0);
+}
+
+TEST_CASE("SortStats descending bit range") {
+    auto arr    = std::vector<uint64_t>(1000);
+    auto sorter = StatSorter();
+    auto key    = descending(bit_range<16, 40>());
+    auto ukey   = [](uint64_t x) { return ~(x >> 16U) & 0xFFFFFFU; };
+    static_assert(key_low_bits<decltype(key(uint64_t{}))>::value == 16, "low_bits not forwarded");
+    for (uint64_t& elem : arr)
+        elem = static_cast<uint64_t>(rand()) << 9U;  // bits [16, 40) vary, the ones below too
+
+    sorter.radix_sort_lsd(arr, key);
+    CHECK(is_sorted(arr, ukey));
+    CHECK(sorter.stats().passes_run == 3);
+    CHECK(sorter.stats().passes_skipped == 0);  // the bytes below Lo are not even counted
+
+    for (uint64_t& elem : arr)
+        elem = static_cast<uint64_t>(rand()) << 9U;
+    sorter.stats().reset();
+    sorter.radix_sort_msd(arr, key);
+    CHECK(is_sorted(arr, ukey));
+}
+
+TEST_CASE("SortStats sort dispatch") {
+    auto arr    = std::vector<ClassType<double>>(10000);
+    auto sorter = StatSorter();
+    auto key    = [](ClassType<double> const& c) { return static_cast<double>(c); };
+    auto n_sort = uint64_t{0};
+    for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3, ++n_sort) {
+        auto subseq = make_span(arr.data(), sz);
+        for (auto& elem : subseq)
+            elem = ClassType<double>(rand() * 0.5);
+        sorter.sort(subseq, key);
+        CHECK(is_sorted(subseq, key));
+    }
+
+    auto const& st    = sorter.stats();
+    uint64_t    calls = 0;
+    for (auto const& as : st.sort_algos)
+        calls += as.calls;
+    CHECK(calls == n_sort);
+    CHECK(st.of(SortAlgo::insertion).calls > 0);
+    CHECK(st.of(SortAlgo::key_index).calls > 0);  // ClassType is not trivially copyable
+    CHECK(st.key_calls > 0);
+    CHECK(st.elems_moved > 0);
+
+    sorter.radix_sort_msd(arr, key);
+    CHECK(st.of(SortAlgo::radix_msd).calls == 1);
+    CHECK(st.insertion_fallbacks > 0);
+
+    sorter.nth_element(arr, 5000, key);
+    sorter.dutch_nth_elem(arr, 5000, key);
+    CHECK(is_nth_elem(arr, 5000, key));
+    CHECK(st.of(NthAlgo::radix).calls == 1);
+    CHECK(st.of(NthAlgo::dutch).calls == 1);
+}
+
+TEST_CASE("SortStats radix_sort_str and insertion_sort") {
+    auto strs   = std::vector<std::string>{"pear", "apple", "fig", "apricot", "", "apple"};
+    auto sorter = StatSorter();
+    sorter.radix_sort_str(strs);
+    CHECK(is_sorted(strs));
+
+    auto const& st = sorter.stats();
+    CHECK(st.of(SortAlgo::radix_str).calls == 1);
+    CHECK(st.of(SortAlgo::radix_str).elems == strs.size());
+    CHECK(st.key_calls >= strs.size());
+
+    auto arr = std::vector<int>{3, 1, 2};
+    StatSorter::insertion_sort(arr);  // static, not recorded
+    CHECK(is_sorted(arr));
+    CHECK(st.of(SortAlgo::insertion).calls == 0);
+}
+
+namespace {
+    /// Hands out the same small block whatever the size, to track capacities above 4 GB
+    struct FakeAllocator {
+        using value_type = char;
+
+        char* allocate(size_t n) {
+            last = n;
+            return block;
+        }
+
+        void deallocate(char* /*ptr*/, size_t /*n*/) noexcept {
+        }
+
+        char   block[64] = {};
+        size_t last      = 0;
+    };
+}  // namespace
+
+TEST_CASE("Sorter buffer growth, reserve and trim") {
+    auto        sorter = StatSorter();
+    auto        arr    = std::vector<uint32_t>(1000);
+    auto const& st     = sorter.stats();
+    sorter.radix_sort_lsd(arr);
+    CHECK(sorter.capacity() == 4000);
+
+    arr.resize(1100);  // grows by 1.5x at least
+    sorter.radix_sort_lsd(arr);
+    CHECK(sorter.capacity() == 6000);
+    arr.resize(1400);
+    sorter.radix_sort_lsd(arr);
+    CHECK(st.buff_reallocs == 2);
+
+    sorter.reserve(100000);
+    CHECK(sorter.capacity() == 100000);
+    sorter.reserve(10);
+    CHECK(sorter.capacity() == 100000);
+    CHECK(st.buff_reallocs == 3);
+
+    sorter.set_high_water_mark(10000);
+    CHECK(sorter.high_water_mark() == 10000);
+    arr.resize(50000);  // spike above the mark, kept until a smaller call
+    sorter.radix_sort_lsd(arr);
+    CHECK(sorter.capacity() == 200000);
+    arr.resize(1000);
+    sorter.radix_sort_lsd(arr);
+    CHECK(is_sorted(arr));
+    CHECK(sorter.capacity() == 4000);
+    CHECK(st.buff_releases == 1);
+    arr.resize(2000);  // growth capped by the mark
+    sorter.radix_sort_lsd(arr);
+    CHECK(sorter.capacity() == 8000);
+    arr.resize(2100);
+    sorter.radix_sort_lsd(arr);
+    CHECK(sorter.capacity() == 10000);
+
+    sorter.shrink_to_fit();
+    CHECK(sorter.capacity() == 0);
+    CHECK(st.buff_bytes == 0);
+    CHECK(st.buff_releases == 2);
+    CHECK(st.buff_peak_bytes == 200000);
+    sorter.shrink_to_fit();
+    CHECK(st.buff_releases == 2);
+
+    auto big = Sorter<uint32_t, FakeAllocator>();
+    big.reserve(size_t{5} << 30U);
+    CHECK(big.capacity() == size_t{5} << 30U);
+    CHECK(big.get_allocator().last == size_t{5} << 30U);
+}
+
+TEST_CASE("Sorter move") {
+    auto sorter = StatSorter();
+    auto arr    = std::vector<double>(1000, 1.0);
+    sorter.radix_sort_lsd(arr);
+
+    auto moved = std::move(sorter);
+    CHECK(moved.capacity() == 8000);
+    CHECK(moved.stats().buff_reallocs == 1);
+    CHECK(sorter.capacity() == 0);
+    sorter.radix_sort_lsd(arr);
+    CHECK(sorter.capacity() == 8000);
+
+    moved = std::move(sorter);
+    CHECK(moved.capacity() == 8000);
+    CHECK(sorter.capacity() == 0);
+    moved.radix_sort_msd(arr);
+    CHECK(is_sorted(arr));
+}
+
+}  // namespace cav
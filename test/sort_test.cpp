@@ -9,10 +9,37 @@
 
 #include <doctest/doctest.h>
 
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "Span.hpp"
 #include "../src/ClassType.hpp"
 
 namespace cav {
+namespace {
+    /// Fixed-point key with no comparison operators: ordered only through key_traits
+    struct Fixed32 {
+        int32_t raw;
+    };
+}  // namespace
+
+template <>
+struct key_traits<Fixed32> {
+    using ukey_type = uint32_t;
+
+    static uint32_t to_uint(Fixed32 f) noexcept {
+        return cav::to_uint(f.raw);
+    }
+};
+
+namespace {
+    struct Record {
+        int32_t score;
+        float   weight;
+        char    pad[8];
+    };
+}  // namespace
 
 TEST_CASE("sort int") {
     auto arr    = std::vector<int>(10000);
@@ -576,4 +603,286 @@ TEST_CASE("nth_element algo specific ClassType<double>") {
     }
 }
 
-}  // namespace cav
\ No newline at end of file
+TEST_CASE("sort and nth_element wide keys") {
+    auto arr    = std::vector<std::array<uint8_t, 16>>(10000);
+    auto sorter = cav::Sorter<>();
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (auto& elem : subseq) {
+                elem = std::array<uint8_t, 16>{{0x01, 0x02, 0x03, 0x04}};
+                for (size_t b = 8; b < elem.size(); ++b)
+                    elem[b] = static_cast<uint8_t>(rand());
+            }
+            REQUIRE_NOTHROW(sorter.sort(subseq));
+            CHECK(is_sorted(subseq));
+
+            for (auto& elem : subseq)
+                elem[15] = static_cast<uint8_t>(rand());
+            REQUIRE_NOTHROW(sorter.nth_element(subseq, cav::size(subseq) / 2));
+            CHECK(is_nth_elem(subseq, cav::size(subseq) / 2));
+        }
+    }
+}
+
+TEST_CASE("sort and nth_element custom keys") {
+    auto arr    = std::vector<Fixed32>(10000);
+    auto sorter = cav::Sorter<>();
+    auto ukey   = [](Fixed32 f) { return to_uint(f); };
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (Fixed32& elem : subseq)
+                elem = Fixed32{rand() % 1024 - 512};
+            REQUIRE_NOTHROW(sorter.sort(subseq));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (Fixed32& elem : subseq)
+                elem = Fixed32{rand() % 1024 - 512};
+            REQUIRE_NOTHROW(sorter.radix_sort_msd(subseq));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (Fixed32& elem : subseq)
+                elem = Fixed32{rand() % 1024 - 512};
+            REQUIRE_NOTHROW(sorter.net_sort(subseq));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (Fixed32& elem : subseq)
+                elem = Fixed32{rand() % 1024 - 512};
+            REQUIRE_NOTHROW(sorter.nth_element(subseq, cav::size(subseq) / 2));
+            CHECK(is_nth_elem(subseq, cav::size(subseq) / 2, ukey));
+        }
+    }
+}
+
+TEST_CASE("sort and nth_element descending") {
+    auto arr    = std::vector<int>(10000);
+    auto sorter = cav::Sorter<>();
+    auto rev    = [](int x) { return Desc<int>{x}; };
+    auto ukey   = [](int x) { return to_uint(desc(x)); };
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (int& elem : subseq)
+                elem = rand() % 3 == 0 ? limits<int>::min() : rand() - RAND_MAX / 2;
+            REQUIRE_NOTHROW(sorter.sort(subseq, descending()));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (int& elem : subseq)
+                elem = rand() % 3 == 0 ? limits<int>::min() : rand() - RAND_MAX / 2;
+            REQUIRE_NOTHROW(sorter.radix_sort_lsd(subseq, rev));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (int& elem : subseq)
+                elem = rand() % 3 == 0 ? limits<int>::min() : rand() - RAND_MAX / 2;
+            REQUIRE_NOTHROW(sorter.radix_sort_msd(subseq, descending()));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (int& elem : subseq)
+                elem = rand() % 3 == 0 ? limits<int>::min() : rand() - RAND_MAX / 2;
+            REQUIRE_NOTHROW(sorter.net_sort(subseq, descending()));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (int& elem : subseq)
+                elem = rand() - RAND_MAX / 2;
+            REQUIRE_NOTHROW(sorter.nth_element(subseq, cav::size(subseq) / 2, descending()));
+            CHECK(is_nth_elem(subseq, cav::size(subseq) / 2, ukey));
+        }
+    }
+}
+
+TEST_CASE("sort and nth_element bit range") {
+    auto arr    = std::vector<uint64_t>(10000);
+    auto sorter = cav::Sorter<>();
+    auto range  = bit_range<8, 40>();
+    auto ukey   = [](uint64_t x) { return (x >> 8U) & 0xFFFFFFFFU; };
+    auto rnd64  = []() { return (static_cast<uint64_t>(rand()) << 31U) ^ rand(); };
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (uint64_t& elem : subseq)
+                elem = rnd64();
+            REQUIRE_NOTHROW(sorter.sort(subseq, range));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (uint64_t& elem : subseq)
+                elem = rnd64();
+            REQUIRE_NOTHROW(sorter.radix_sort_lsd(subseq, range));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (uint64_t& elem : subseq)
+                elem = rnd64();
+            REQUIRE_NOTHROW(sorter.radix_sort_msd(subseq, range));
+            CHECK(is_sorted(subseq, ukey));
+
+            for (uint64_t& elem : subseq)
+                elem = rnd64();
+            REQUIRE_NOTHROW(sorter.radix_nth_elem(subseq, cav::size(subseq) / 2, range));
+            CHECK(is_nth_elem(subseq, cav::size(subseq) / 2, ukey));
+
+            for (uint64_t& elem : subseq)
+                elem = rnd64();
+            REQUIRE_NOTHROW(sorter.dutch_nth_elem(subseq, cav::size(subseq) / 2, range));
+            CHECK(is_nth_elem(subseq, cav::size(subseq) / 2, ukey));
+        }
+    }
+}
+
+TEST_CASE("sort composite keys") {
+    auto arr    = std::vector<Record>(10000);
+    auto sorter = cav::Sorter<>();
+    auto key    = [](Record const& r) { return std::make_tuple(desc(r.score), r.weight); };
+    auto less   = [](Record const& a, Record const& b) {
+        return a.score != b.score ? a.score > b.score : a.weight < b.weight;
+    };
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+            auto subseq = make_span(arr.data(), sz);
+
+            for (Record& elem : subseq)
+                elem = Record{rand() % 16 - 8, static_cast<float>(rand() % 64) - 32.0F, {}};
+            REQUIRE_NOTHROW(sorter.sort(subseq, key));
+            CHECK(std::is_sorted(subseq.begin(), subseq.end(), less));
+        }
+    }
+}
+
+namespace {
+    /// Not trivially copyable record counting its copies and moves
+    struct Named {
+        std::string name;
+        int         score;
+        size_t      pos;
+
+        static size_t copies;
+        static size_t moves;
+
+        Named(int score, size_t pos)
+            : name("record " + std::to_string(pos))
+            , score(score)
+            , pos(pos) {
+        }
+
+        Named(Named const& other)
+            : name(other.name)
+            , score(other.score)
+            , pos(other.pos) {
+            ++copies;
+        }
+
+        Named(Named&& other) noexcept
+            : name(std::move(other.name))
+            , score(other.score)
+            , pos(other.pos) {
+            ++moves;
+        }
+
+        Named& operator=(Named&& other) noexcept {
+            name  = std::move(other.name);
+            score = other.score;
+            pos   = other.pos;
+            ++moves;
+            return *this;
+        }
+
+        Named& operator=(Named const& other) = default;
+    };
+
+    size_t Named::copies = 0;
+    size_t Named::moves  = 0;
+}  // namespace
+
+TEST_CASE("key_index_sort") {
+    auto sorter = cav::Sorter<>();
+    auto key    = [](Named const& n) { return n.score; };
+    for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+        auto arr = std::vector<Named>();
+        for (size_t i = 0; i < sz; ++i)
+            arr.emplace_back(rand() % 100 - 50, i);
+
+        Named::copies = Named::moves = 0;
+        REQUIRE_NOTHROW(sorter.key_index_sort(arr, key));
+        CHECK(is_sorted(arr, key));
+        CHECK(Named::copies == 0);
+        CHECK(Named::moves <= sz + sz / 2 + 1);  // one per element, one more per cycle (of 2+)
+        for (size_t i = 1; i < sz; ++i) {
+            CHECK(arr[i].name == "record " + std::to_string(arr[i].pos));
+            if (arr[i - 1].score == arr[i].score)
+                CHECK(arr[i - 1].pos < arr[i].pos);  // stable
+        }
+
+        for (Named& elem : arr)
+            elem.score = rand() % 100 - 50;
+        REQUIRE_NOTHROW(sorter.sort(arr, key));
+        CHECK(is_sorted(arr, key));
+    }
+}
+
+TEST_CASE("key_index_sort large records") {
+    struct Fat {
+        double key;
+        char   payload[120];
+    };
+
+    auto arr    = std::vector<Fat>(10000);
+    auto sorter = cav::Sorter<>();
+    auto key    = [](Fat const& f) { return f.key; };
+    for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+        auto subseq = make_span(arr.data(), sz);
+        for (Fat& elem : subseq) {
+            elem.key = (rand() % 1000) * 0.5 - 250.0;
+            std::memset(elem.payload, static_cast<int>(elem.key), sizeof(elem.payload));
+        }
+        REQUIRE_NOTHROW(sorter.key_index_sort(subseq, key));
+        CHECK(is_sorted(subseq, key));
+        for (Fat const& elem : subseq)
+            CHECK(elem.payload[119] == static_cast<char>(static_cast<int>(elem.key)));
+
+        for (Fat& elem : subseq)
+            elem.key = -elem.key;
+        REQUIRE_NOTHROW(sorter.sort(subseq, key));
+        CHECK(is_sorted(subseq, key));
+    }
+}
+
+TEST_CASE("sort_by_key") {
+    auto keys   = std::vector<int>(10000);
+    auto ranks  = std::vector<uint32_t>(10000);
+    auto weight = std::vector<double>(10000);
+    auto names  = std::vector<std::string>(10000);
+    auto sorter = cav::Sorter<>();
+    for (size_t sz = 2; sz <= 10000; sz = sz * 17 / 3) {
+        auto k = make_span(keys.data(), sz);
+        auto r = make_span(ranks.data(), sz);
+        auto w = make_span(weight.data(), sz);
+        auto s = make_span(names.data(), sz);
+        for (size_t i = 0; i < sz; ++i) {
+            k[i] = rand() % 2000 - 1000;
+            r[i] = static_cast<uint32_t>(i);
+            w[i] = k[i] * 0.5;
+            s[i] = std::to_string(k[i]) + " is a key long enough not to fit in place";
+        }
+        REQUIRE_NOTHROW(sorter.sort_by_key(k, r, w, s));
+        CHECK(is_sorted(k));
+        for (size_t i = 0; i < sz; ++i) {
+            CHECK(w[i] == k[i] * 0.5);
+            CHECK(s[i] == std::to_string(k[i]) + " is a key long enough not to fit in place");
+            if (i > 0 && k[i - 1] == k[i])
+                CHECK(r[i - 1] < r[i]);  // stable
+        }
+
+        REQUIRE_NOTHROW(sorter.sort_by_key(r, k));  // back to the original order
+        for (size_t i = 0; i < sz; ++i)
+            CHECK(r[i] == i);
+    }
+
+    auto no_keys = std::vector<int>();
+    auto no_vals = std::vector<std::string>();
+    REQUIRE_NOTHROW(sorter.sort_by_key(no_keys, no_vals));
+}
+
+}  // namespace cav
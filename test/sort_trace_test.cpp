@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#define CAV_SORT_TRACE
+
+#include "sort_trace.hpp"
+
+#include <doctest/doctest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sort.hpp"
+
+namespace cav {
+
+namespace {
+    size_t count_of(std::string const& str, std::string const& what) {
+        size_t count = 0;
+        for (size_t pos = str.find(what); pos != std::string::npos; pos = str.find(what, pos + 1))
+            ++count;
+        return count;
+    }
+
+    std::vector<uint32_t> rand_vector(size_t n) {
+        auto vec = std::vector<uint32_t>(n);
+        for (uint32_t& elem : vec)
+            elem = static_cast<uint32_t>(rand());
+        return vec;
+    }
+}  // namespace
+
+TEST_CASE("trace sort phases") {
+    trace::clear();
+    auto sorter = Sorter<>();
+    auto arr    = rand_vector(5000);
+    sorter.radix_sort_lsd(arr);
+    CHECK(is_sorted(arr));
+
+    arr = rand_vector(5000);
+    for (uint32_t& elem : arr)
+        elem &= 0xFFFFFFU;  // 3 passes, the last one is followed by a move back
+    sorter.radix_sort_lsd(arr);
+    CHECK(is_sorted(arr));
+
+    arr = rand_vector(5000);
+    sorter.radix_sort_msd(arr);
+    CHECK(is_sorted(arr));
+
+    arr = rand_vector(5000);
+    sorter.net_sort(arr);
+    CHECK(is_sorted(arr));
+
+    auto out = std::ostringstream();
+    trace::write_chrome_json(out);
+    auto json = out.str();
+    CHECK(json.find("\"traceEvents\":[") != std::string::npos);
+    CHECK(count_of(json, "\"lsd_histogram\"") == 2);
+    CHECK(count_of(json, "\"lsd_scatter\"") == 7);
+    CHECK(count_of(json, "\"msd_level\"") >= 1);
+    CHECK(count_of(json, "\"net_chunks\"") == 1);
+    CHECK(count_of(json, "\"net_merge\"") == 8);  // 32 * 2^8 >= 5000
+    CHECK(count_of(json, "\"move_uninit_span\"") == 1);
+    CHECK(count_of(json, "\"ph\":\"X\"") == count_of(json, "\"dur\":"));
+}
+
+TEST_CASE("trace per-thread buffers") {
+    trace::clear();
+    uint32_t main_tid = trace::thread_buffer().tid;
+    auto     worker   = [](uint32_t* tid) {
+        auto sorter = Sorter<>();
+        auto arr    = rand_vector(1000);
+        sorter.radix_sort_lsd(arr);
+        *tid = trace::thread_buffer().tid;
+    };
+    uint32_t tid1 = main_tid, tid2 = main_tid;
+    auto     t1   = std::thread(worker, &tid1);
+    auto     t2   = std::thread(worker, &tid2);
+    t1.join();
+    t2.join();
+    CHECK(tid1 != main_tid);
+    CHECK(tid2 != main_tid);
+    CHECK(tid1 != tid2);
+
+    auto out = std::ostringstream();
+    trace::write_chrome_json(out);
+    auto json = out.str();
+    CHECK(count_of(json, "\"lsd_histogram\"") == 2);
+    CHECK(json.find("\"tid\":" + std::to_string(tid1) + ",") != std::string::npos);
+    CHECK(json.find("\"tid\":" + std::to_string(tid2) + ",") != std::string::npos);
+}
+
+}  // namespace cav
@@ -17,6 +17,37 @@
 #include "sort_utils.hpp"
 
 namespace cav {
+namespace {
+    enum class Level : int16_t { low = -3, mid = 0, high = 5 };
+
+    struct Fixed32 {
+        int32_t raw;
+    };
+
+    struct Stamp40 {
+        uint64_t ticks;
+    };
+}  // namespace
+
+template <>
+struct key_traits<Fixed32> {
+    using ukey_type = uint32_t;
+
+    static uint32_t to_uint(Fixed32 f) noexcept {
+        return cav::to_uint(f.raw);
+    }
+};
+
+template <>
+struct key_traits<Stamp40> {
+    using ukey_type              = uint64_t;
+    static constexpr size_t bits = 40;
+
+    static uint64_t to_uint(Stamp40 s) noexcept {
+        return s.ticks;
+    }
+};
+
 TEST_CASE("to_uint") {
     SUBCASE("to_uint(unsigned integers)") {
         for (uint64_t k = 0; k < 1024; k = k * 37 / 11 + 17) {
@@ -68,6 +99,77 @@ TEST_CASE("to_uint") {
     }
 }
 
+TEST_CASE("to_uint wide keys") {
+#ifdef __SIZEOF_INT128__
+    SUBCASE("to_uint(int128_t)") {
+        int128_t prev = -(static_cast<int128_t>(1) << 100U);
+        for (uint64_t k = 0; k < 1024; ++k) {
+            auto val = static_cast<int128_t>(rand() - RAND_MAX / 2) *
+                       (static_cast<int128_t>(1) << 80U);
+            CHECK((val < prev) == (to_uint(val) < to_uint(prev)));
+            CHECK(to_uint(static_cast<uint128_t>(val)) == static_cast<uint128_t>(val));
+            prev = val;
+        }
+    }
+#endif
+
+    SUBCASE("to_uint(std::array<uint8_t, N>)") {
+        auto uuid = std::array<uint8_t, 16>{{0x12, 0x34, 0x56, 0x78}};
+        CHECK(to_uint(uuid) == uuid);
+    }
+}
+
+TEST_CASE("key_traits") {
+    SUBCASE("long and long long") {
+        CHECK((to_uint(-1L) < to_uint(1L)));
+        CHECK((to_uint(-1LL) < to_uint(1LL)));
+        CHECK(to_uint(static_cast<long long>(42)) == to_uint(static_cast<int64_t>(42)));
+        CHECK(to_uint(42ULL) == 42ULL);
+    }
+
+    SUBCASE("enum class") {
+        CHECK(to_uint(Level::low) < to_uint(Level::mid));
+        CHECK(to_uint(Level::mid) < to_uint(Level::high));
+        CHECK(to_uint(Level::mid) == to_uint(int16_t{0}));
+    }
+
+    SUBCASE("user specialization") {
+        CHECK(to_uint(Fixed32{-5}) < to_uint(Fixed32{3}));
+        CHECK((sort::n_bytes<std::vector<Fixed32>, IdentityFtor>() == 4));
+        CHECK((sort::n_bytes<std::vector<Stamp40>, IdentityFtor>() == 5));
+        CHECK((sort::n_bytes<std::vector<int64_t>, IdentityFtor>() == 8));
+    }
+
+    SUBCASE("bit range") {
+        using range_ftor = BitRangeFtor<16, 40>;
+        CHECK(to_uint(bit_range<16, 40>()(0x123456789ABCULL)) == 0x3456780000ULL);
+        CHECK(to_uint(bit_range<0, 12>()(-1)) == 0xFFFU);
+        CHECK((sort::n_bytes<std::vector<uint64_t>, range_ftor>() == 5));
+        CHECK((sort::lo_byte<std::vector<uint64_t>, range_ftor>() == 2));
+        CHECK((sort::lo_byte<std::vector<uint64_t>, IdentityFtor>() == 0));
+    }
+}
+
+TEST_CASE("descending and composite keys") {
+    SUBCASE("desc") {
+        CHECK(to_uint(desc(limits<int32_t>::min())) > to_uint(desc(limits<int32_t>::max())));
+        CHECK(to_uint(desc(0U)) > to_uint(desc(limits<uint32_t>::max())));
+        CHECK(to_uint(desc(-1.5)) > to_uint(desc(2.5)));
+        CHECK(to_uint(desc(Level::low)) > to_uint(desc(Level::high)));
+        CHECK((sort::n_bytes<std::vector<Desc<Stamp40>>, IdentityFtor>() == 5));
+    }
+
+    SUBCASE("tuple") {
+        using key_type = std::tuple<Desc<int16_t>, uint8_t>;
+        CHECK((std::is_same<key_traits<key_type>::ukey_type, uint32_t>::value));
+        CHECK((sort::n_bytes<std::vector<key_type>, IdentityFtor>() == 3));
+        CHECK(to_uint(key_type{desc<int16_t>(2), 0}) < to_uint(key_type{desc<int16_t>(1), 0}));
+        CHECK(to_uint(key_type{desc<int16_t>(1), 0}) < to_uint(key_type{desc<int16_t>(1), 1}));
+        CHECK(to_uint(std::make_tuple(desc(Stamp40{1}), uint8_t{7})) ==
+              ((~1ULL & 0xFFFFFFFFFFULL) << 8U | 7U));
+    }
+}
+
 TEST_CASE("nth_byte") {
     SUBCASE("uint8_t") {
         uint32_t k = 0x12;
@@ -101,6 +203,27 @@ TEST_CASE("nth_byte") {
     }
 }
 
+TEST_CASE("nth_byte wide keys") {
+#ifdef __SIZEOF_INT128__
+    SUBCASE("uint128_t") {
+        auto k = (static_cast<uint128_t>(0x0123456789ABCDEF) << 64U) | 0xFEDCBA9876543210;
+        CHECK(cav::nth_byte<15>(k) == 0x01);
+        CHECK(cav::nth_byte<8>(k) == 0xEF);
+        CHECK(cav::nth_byte<7>(k) == 0xFE);
+        CHECK(cav::nth_byte(k, 0) == 0x10);
+    }
+#endif
+
+    SUBCASE("std::array<uint8_t, 20>") {
+        auto k = std::array<uint8_t, 20>{};
+        for (uint8_t i = 0; i < 20; ++i)
+            k[i] = i;
+        CHECK(cav::nth_byte<19>(k) == 0);
+        CHECK(cav::nth_byte<0>(k) == 19);
+        CHECK(cav::nth_byte(k, 5) == 14);
+    }
+}
+
 TEST_CASE("move_uninit") {
     SUBCASE("move_uninit(D&, S&) - trivially copiable types") {
         int src = 42;
@@ -135,6 +258,17 @@ TEST_CASE("move_uninit_span") {
     }
 }
 
+TEST_CASE("insertion_sort custom key") {
+    auto arr = std::vector<Fixed32>(200);
+    for (size_t sz = 2; sz <= 200; sz = sz * 17 / 3) {
+        auto subseq = make_span(arr.data(), sz);
+        for (Fixed32& elem : subseq)
+            elem = Fixed32{rand() % 1024 - 512};
+        REQUIRE_NOTHROW(insertion_sort(subseq));
+        CHECK(is_sorted(subseq, [](Fixed32 f) { return to_uint(f); }));
+    }
+}
+
 TEST_CASE("insertion_sort int") {
     auto arr  = std::vector<int>(200);
     auto buff = std::vector<int>(200);
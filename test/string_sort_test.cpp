@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "string_sort.hpp"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Span.hpp"
+#include "sort.hpp"
+
+namespace cav {
+
+namespace {
+    std::string rand_string(size_t max_len) {
+        static char const prefixes[][16] = {"", "https://", "https://www.", "id_0000"};
+        auto              str            = std::string(prefixes[rand() % 4]);
+        size_t            len            = rand() % (max_len + 1);
+        for (size_t i = 0; i < len; ++i)
+            str.push_back(static_cast<char>(rand() % 4 == 0 ? rand() % 256 : 'a' + rand() % 3));
+        return str;
+    }
+
+    struct Record {
+        int         id;
+        std::string name;
+    };
+}  // namespace
+
+TEST_CASE("radix_sort_str std::string") {
+    auto arr  = std::vector<std::string>(5000);
+    auto buff = std::vector<StrEntry<std::string>>(10000);
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 5000; s = s * 17 / 3) {
+            auto subseq = make_span(arr.data(), s);
+
+            for (std::string& elem : subseq)
+                elem = rand_string(i * 4);
+            auto expected = std::vector<std::string>(subseq.begin(), subseq.end());
+            std::sort(expected.begin(), expected.end());
+            REQUIRE_NOTHROW(radix_sort_str<int>(subseq, buff));
+            CHECK(std::equal(subseq.begin(), subseq.end(), expected.begin()));
+        }
+    }
+}
+
+TEST_CASE("radix_sort_str embedded zeros and empty strings") {
+    auto arr = std::vector<std::string>();
+    for (size_t i = 0; i < 300; ++i) {
+        arr.push_back(std::string(i % 11, '\0'));
+        arr.push_back(std::string());
+        arr.push_back(std::string(i % 13, 'a') + std::string(1, '\0'));
+    }
+    auto buff     = std::vector<StrEntry<std::string>>(2 * arr.size());
+    auto expected = arr;
+    std::sort(expected.begin(), expected.end());
+    REQUIRE_NOTHROW(radix_sort_str<int>(arr, buff));
+    CHECK(arr == expected);
+}
+
+TEST_CASE("radix_sort_str struct field") {
+    auto arr    = std::vector<Record>(3000);
+    auto sorter = Sorter<>();
+    for (size_t i = 0; i < 10; ++i) {
+        for (size_t s = 2; s <= 3000; s = s * 17 / 3) {
+            auto subseq = make_span(arr.data(), s);
+
+            for (size_t j = 0; j < s; ++j)
+                subseq[j] = Record{static_cast<int>(j), rand_string(20)};
+            REQUIRE_NOTHROW(
+                sorter.radix_sort_str(subseq, [](Record const& r) -> std::string const& {
+                    return r.name;
+                }));
+            CHECK(is_sorted(subseq, [](Record const& r) { return r.name; }));
+
+            auto ids = std::vector<int>();
+            for (Record const& r : subseq)
+                ids.push_back(r.id);
+            std::sort(ids.begin(), ids.end());
+            for (size_t j = 0; j < s; ++j)
+                CHECK(ids[j] == static_cast<int>(j));
+        }
+    }
+}
+
+}  // namespace cav
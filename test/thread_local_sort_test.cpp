@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#define CAV_TL_MAX_CACHED_BYTES 4096U
+
+#include "thread_local_sort.hpp"
+
+#include <doctest/doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "../src/ClassType.hpp"
+
+namespace cav {
+
+TEST_CASE("tl sort and nth_element") {
+    auto arr = std::vector<int64_t>(1000);
+    for (int64_t& elem : arr)
+        elem = rand() - RAND_MAX / 2;
+    tl::sort(arr);
+    CHECK(is_sorted(arr));
+    CHECK(tl::sorter().capacity() == 0);  // above the bound, released
+    CHECK(tl::sorter<uint64_t>().capacity() == 0);
+
+    auto cls = std::vector<ClassType<double>>(300);
+    auto key = [](ClassType<double> const& c) { return static_cast<double>(c); };
+    for (auto& elem : cls)
+        elem = ClassType<double>(rand() * 0.5);
+    tl::nth_element(cls, 150, key);
+    CHECK(is_nth_elem(cls, 150, key));
+    tl::sort<uint64_t>(cls, key);
+    CHECK(is_sorted(cls, key));
+
+    arr.resize(200);
+    tl::sort(arr, [](int64_t v) { return -v; });
+    CHECK(is_sorted(arr, [](int64_t v) { return -v; }));
+    CHECK(tl::sorter().capacity() == 200 * sizeof(int64_t));  // kept
+    tl::release();
+    CHECK(tl::sorter().capacity() == 0);
+}
+
+TEST_CASE("tl argsort") {
+    auto arr  = std::vector<float>{3.0F, -1.0F, 2.5F, 0.0F, -7.0F};
+    auto idxs = tl::argsort(arr);
+    CHECK(idxs == std::vector<uint32_t>{4, 1, 3, 2, 0});
+
+    auto big = std::vector<ClassType<int>>(5000);
+    auto key = [](ClassType<int> const& c) { return static_cast<int>(c); };
+    for (auto& elem : big)
+        elem = ClassType<int>(rand() % 100);
+    auto order = tl::argsort<uint16_t>(big, key);
+    REQUIRE(order.size() == big.size());
+    for (size_t i = 1; i < order.size(); ++i)
+        CHECK(key(big[order[i - 1]]) <= key(big[order[i]]));
+    CHECK(tl::argsort(std::vector<int>()).empty());
+}
+
+TEST_CASE("tl sort_by_key") {
+    auto keys = std::vector<double>{0.5, -2.0, 3.0, -2.0};
+    auto ids  = std::vector<uint8_t>{0, 1, 2, 3};
+    tl::sort_by_key(keys, ids);
+    CHECK(keys == std::vector<double>{-2.0, -2.0, 0.5, 3.0});
+    CHECK(ids == std::vector<uint8_t>{1, 3, 0, 2});
+}
+
+TEST_CASE("tl nested calls and threads") {
+    Sorter<uint32_t>* outer = nullptr;
+    Sorter<uint32_t>* inner = nullptr;
+    tl::with_sorter<uint32_t>([&](Sorter<uint32_t>& s) {
+        outer = &s;
+        tl::with_sorter<uint32_t>([&](Sorter<uint32_t>& t) { inner = &t; });
+    });
+    CHECK(outer == &tl::sorter());
+    CHECK(inner != outer);
+
+    auto results = std::vector<int>(4, 0);
+    auto workers = std::vector<std::thread>();
+    for (int t = 0; t < 4; ++t)
+        workers.emplace_back([&results, t] {
+            auto arr = std::vector<uint32_t>(300);
+            bool ok  = true;
+            for (int rep = 0; rep < 50; ++rep) {
+                for (uint32_t& elem : arr)
+                    elem = static_cast<uint32_t>(rep * 7919 + t) * 2654435761U;
+                tl::sort(arr);
+                ok = ok && is_sorted(arr);
+            }
+            results[t] = ok && tl::sorter().capacity() > 0 ? 1 : 0;
+        });
+    for (std::thread& worker : workers)
+        worker.join();
+    CHECK(results == std::vector<int>(4, 1));
+}
+
+}  // namespace cav
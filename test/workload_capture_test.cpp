@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+// SPDX-License-Identifier: MIT
+
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+
+#include "workload_capture.hpp"
+
+#include <doctest/doctest.h>
+
+#include <array>
+#include <sstream>
+#include <vector>
+
+#include "../src/ClassType.hpp"
+#include "sort.hpp"
+
+namespace cav {
+
+using CaptureSorter = Sorter<uint32_t, std::allocator<char>, WorkloadCapture>;
+
+TEST_CASE("WorkloadCapture records shapes, sizes and byte histograms") {
+    auto sorter                = CaptureSorter();
+    sorter.stats().sample_log2 = 0;  // sample every call
+
+    auto arr = std::vector<uint32_t>(1000);
+    for (uint32_t& elem : arr)
+        elem = static_cast<uint32_t>(rand() % 256) << 8U;  // only the second byte varies
+    sorter.sort(arr);
+    CHECK(is_sorted(arr));
+    arr.resize(10);
+    sorter.sort(arr);
+
+    auto flt = std::vector<ClassType<float, 16>>(100, ClassType<float, 16>(-1.0F));
+    sorter.sort(flt, [](ClassType<float, 16> const& v) { return float(v); });
+
+    auto const& shapes = sorter.stats().shapes;
+    REQUIRE(shapes.size() == 2);
+    CHECK(shapes[0].key_kind == 'u');
+    CHECK(shapes[0].key_size == 4);
+    CHECK(shapes[0].val_size == 4);
+    CHECK(shapes[0].calls == 2);
+    CHECK(shapes[0].sampled == 2);
+    CHECK(shapes[0].sizes == std::vector<uint64_t>{1000, 10});
+    REQUIRE(shapes[0].byte_hist.size() == 4);
+    CHECK(shapes[0].byte_hist[0][0] == 1010);  // the low byte is always zero
+    CHECK(shapes[0].byte_hist[3][0] == 1010);
+    uint64_t tot = 0;
+    for (uint64_t count : shapes[0].byte_hist[1])
+        tot += count;
+    CHECK(tot == 1010);
+
+    CHECK(shapes[1].key_kind == 'f');
+    CHECK(shapes[1].key_size == 4);
+    CHECK(shapes[1].val_size == 16);
+    CHECK(shapes[1].byte_hist[3][to_uint(-1.0F) >> 24U] == 100);
+}
+
+TEST_CASE("WorkloadCapture samples a fraction of the calls") {
+    auto sorter = CaptureSorter();
+    auto arr    = std::vector<int64_t>(8);
+    for (int i = 0; i < 4096; ++i)
+        sorter.sort(arr);
+    WorkloadShape const& shape = sorter.stats().shapes.at(0);
+    CHECK(shape.key_kind == 'i');
+    CHECK(shape.calls == 4096);
+    CHECK(shape.sampled > 4096 / 64 / 2);
+    CHECK(shape.sampled < 4096 / 64 * 2);
+    CHECK(shape.sizes.size() == shape.sampled);
+}
+
+TEST_CASE("WorkloadCapture save and load") {
+    auto sorter                = CaptureSorter();
+    sorter.stats().sample_log2 = 0;
+    auto arr                   = std::vector<double>{3.0, -1.0, 2.5};
+    auto idx                   = std::vector<uint16_t>{2, 0, 1};
+    sorter.sort(arr);
+    sorter.sort(idx, [&](uint16_t i) { return arr[i]; });
+
+    auto buff = std::stringstream();
+    sorter.stats().save(buff);
+    auto loaded = WorkloadCapture();
+    CHECK(loaded.load(buff));
+    REQUIRE(loaded.shapes.size() == 2);
+    for (size_t s = 0; s < 2; ++s) {
+        WorkloadShape const& orig = sorter.stats().shapes[s];
+        WorkloadShape const& copy = loaded.shapes[s];
+        CHECK(copy.key_kind == orig.key_kind);
+        CHECK(copy.key_size == orig.key_size);
+        CHECK(copy.val_size == orig.val_size);
+        CHECK(copy.calls == orig.calls);
+        CHECK(copy.sizes == orig.sizes);
+        CHECK(copy.byte_hist == orig.byte_hist);
+    }
+    CHECK(loaded.shapes[1].val_size == 2);
+
+    auto bad = std::stringstream("cav-workload 1\nshape u 4 4 1 1 4\nsizes 1 3\nhist 1 2\n");
+    CHECK_FALSE(loaded.load(bad));
+    auto no_size = std::stringstream("cav-workload 1\nshape u 4 4 1 1 0\nsizes 2 0 0\n");
+    CHECK_FALSE(loaded.load(no_size));
+    auto huge = std::stringstream("cav-workload 1\nshape u 4 4 1 1 4000000000\nsizes 0\n");
+    CHECK_FALSE(loaded.load(huge));
+}
+
+TEST_CASE("WorkloadCapture save and load wide keys") {
+    auto sorter                = CaptureSorter();
+    sorter.stats().sample_log2 = 0;
+    auto arr                   = std::vector<std::array<uint8_t, 40>>(100);
+    for (auto& elem : arr)
+        elem[39] = static_cast<uint8_t>(rand());
+    sorter.sort(arr);
+
+    auto buff = std::stringstream();
+    sorter.stats().save(buff);
+    auto loaded = WorkloadCapture();
+    CHECK(loaded.load(buff));
+    REQUIRE(loaded.shapes.size() == 1);
+    CHECK(loaded.shapes[0].byte_hist.size() == 40);
+    CHECK(loaded.shapes[0].byte_hist == sorter.stats().shapes[0].byte_hist);
+}
+
+}  // namespace cav
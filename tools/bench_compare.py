@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Francesco Cavaliere <francescocava95@gmail.com>
+# SPDX-License-Identifier: MIT
+
+"""Compares two JSON result files of the benchmarks (sort, nth_elem, net_bench, ...).
+
+Rows are matched by bench, type, dist, segment and algo (and scenario/size for latency). For each
+row it reports the change of the median time of NEW with respect to OLD, a bootstrap confidence
+interval of the ratio of the medians and the two-sided p-value of a Mann-Whitney U test on the
+samples of the repetitions. A row is flagged as a regression (or improvement) when the change is
+larger than --threshold, the p-value is smaller than --alpha and the interval does not contain 1.
+The exit code is 1 if any row regressed, so it can gate a commit:
+
+    ./build/sort --reps 15 --format json > old.json   # on the old commit
+    ./build/sort --reps 15 --format json > new.json   # on the new one
+    tools/bench_compare.py old.json new.json --threshold 0.03
+
+Only the standard library is needed.
+"""
+
+import argparse
+import json
+import math
+import random
+import statistics
+import sys
+
+KEY_FIELDS = ("bench", "type", "dist", "scenario", "segment", "size", "algo")
+EXACT_MAX_SAMPLES = 20  # larger samples (or ties) use the normal approximation of U
+
+
+def load_rows(path, metric):
+    """Maps the key of each record of `path` to (samples, valid)."""
+    with open(path) as file:
+        records = json.load(file)
+    rows = {}
+    for rec in records:
+        key = tuple(str(rec[f]) for f in KEY_FIELDS if f in rec)
+        samples = rec.get("samples_ns") or []
+        if not samples and rec.get(metric) is not None:
+            samples = [rec[metric]]  # files without samples: no statistics, just the ratio
+        rows[key] = (samples, rec.get("valid", True))
+    return rows
+
+
+def mann_whitney_u(xs, ys):
+    """Two-sided p-value of the Mann-Whitney U test (exact without ties on small samples)."""
+    n1, n2 = len(xs), len(ys)
+    pooled = sorted([(v, 0) for v in xs] + [(v, 1) for v in ys])
+    rank_sum, ties, i = 0.0, [], 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        avg_rank = (i + j) / 2.0 + 1.0
+        rank_sum += avg_rank * sum(1 for k in range(i, j + 1) if pooled[k][1] == 0)
+        if j > i:
+            ties.append(j - i + 1)
+        i = j + 1
+    u = rank_sum - n1 * (n1 + 1) / 2.0
+
+    if not ties and n1 <= EXACT_MAX_SAMPLES and n2 <= EXACT_MAX_SAMPLES:
+        dist = u_distribution(n1, n2)
+        total = float(sum(dist))
+        lower = sum(dist[: int(u) + 1]) / total
+        upper = sum(dist[int(u):]) / total
+        return min(1.0, 2.0 * min(lower, upper))
+
+    n = n1 + n2
+    tie_term = sum(t ** 3 - t for t in ties) / float(n * (n - 1))
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - tie_term))
+    if sigma == 0.0:
+        return 1.0
+    z = max(0.0, abs(u - n1 * n2 / 2.0) - 0.5) / sigma
+    return math.erfc(z / math.sqrt(2.0))
+
+
+def u_distribution(n1, n2):
+    """Number of arrangements of n1 and n2 elements giving each value of U (no ties)."""
+    # counts[i][j][u]: arrangements of i and j elements with statistic u
+    counts = [[None] * (n2 + 1) for _ in range(n1 + 1)]
+    for i in range(n1 + 1):
+        for j in range(n2 + 1):
+            if i == 0 or j == 0:
+                counts[i][j] = [1]
+                continue
+            size = i * j + 1
+            cur = [0] * size
+            for u, c in enumerate(counts[i - 1][j]):  # the largest element is from the first
+                cur[u + j] += c
+            for u, c in enumerate(counts[i][j - 1]):  # the largest element is from the second
+                cur[u] += c
+            counts[i][j] = cur
+    return counts[n1][n2]
+
+
+def min_p_value(n1, n2):
+    """Smallest p-value the exact test can give, with fewer repetitions nothing is significant."""
+    if n1 > EXACT_MAX_SAMPLES or n2 > EXACT_MAX_SAMPLES:
+        return 0.0
+    return min(1.0, 2.0 / math.comb(n1 + n2, n1))
+
+
+def bootstrap_ratio_ci(xs, ys, n_resamples, confidence, rng):
+    """Percentile bootstrap interval of median(ys) / median(xs)."""
+    if len(xs) < 2 and len(ys) < 2:
+        return None
+    ratios = []
+    for _ in range(n_resamples):
+        mx = statistics.median(rng.choices(xs, k=len(xs)))
+        my = statistics.median(rng.choices(ys, k=len(ys)))
+        if mx > 0:
+            ratios.append(my / mx)
+    if not ratios:
+        return None
+    ratios.sort()
+    tail = (1.0 - confidence) / 2.0
+    lo = ratios[int(tail * (len(ratios) - 1))]
+    hi = ratios[int(math.ceil((1.0 - tail) * (len(ratios) - 1)))]
+    return lo, hi
+
+
+def parse_args(argv):
+    parser = argparse.ArgumentParser(
+        description=__doc__.splitlines()[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="\n".join(__doc__.splitlines()[2:]))
+    parser.add_argument("old", help="JSON results of the baseline")
+    parser.add_argument("new", help="JSON results to compare against the baseline")
+    parser.add_argument("--metric", default="median_ns",
+                        help="field used when a record has no samples (default: median_ns)")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative change flagged as regression/improvement (default: 0.05)")
+    parser.add_argument("--alpha", type=float, default=0.05,
+                        help="significance level of the Mann-Whitney test (default: 0.05)")
+    parser.add_argument("--confidence", type=float, default=0.95,
+                        help="confidence of the bootstrap interval (default: 0.95)")
+    parser.add_argument("--bootstrap", type=int, default=2000,
+                        help="bootstrap resamples (default: 2000)")
+    parser.add_argument("--seed", type=int, default=42, help="bootstrap seed (default: 42)")
+    parser.add_argument("--changes-only", action="store_true",
+                        help="print only regressions, improvements and mismatching rows")
+    return parser.parse_args(argv)
+
+
+def main(argv):
+    args = parse_args(argv)
+    old_rows = load_rows(args.old, args.metric)
+    new_rows = load_rows(args.new, args.metric)
+    rng = random.Random(args.seed)
+
+    lines = []
+    n_regressions, n_improvements, n_underpowered = 0, 0, 0
+    for key in list(old_rows) + [k for k in new_rows if k not in old_rows]:
+        old, new = old_rows.get(key), new_rows.get(key)
+        name = " ".join(key)
+        if old is None or new is None:
+            lines.append((name, "", "", "", "", "", "only in " + ("new" if old is None else "old")))
+            continue
+        (xs, old_valid), (ys, new_valid) = old, new
+        if not old_valid or not new_valid:
+            lines.append((name, "", "", "", "", "", "WRONG result"))
+            continue
+        if not xs or not ys:
+            continue  # not measured (e.g. no network of this size)
+
+        mx, my = statistics.median(xs), statistics.median(ys)
+        change = my / mx - 1.0 if mx > 0 else 0.0
+        ci = bootstrap_ratio_ci(xs, ys, args.bootstrap, args.confidence, rng)
+        p_value = mann_whitney_u(xs, ys) if len(xs) > 1 and len(ys) > 1 else float("nan")
+        significant = p_value < args.alpha and (ci is None or ci[0] > 1.0 or ci[1] < 1.0)
+        if min_p_value(len(xs), len(ys)) >= args.alpha:
+            n_underpowered += 1
+
+        verdict = ""
+        if significant and change > args.threshold:
+            verdict = "REGRESSION"
+            n_regressions += 1
+        elif significant and change < -args.threshold:
+            verdict = "improved"
+            n_improvements += 1
+        if args.changes_only and not verdict:
+            continue
+        ci_str = "[{:+.1%}, {:+.1%}]".format(ci[0] - 1.0, ci[1] - 1.0) if ci else "-"
+        p_str = "{:.4f}".format(p_value) if not math.isnan(p_value) else "-"
+        lines.append((name, "{:.3f}".format(mx), "{:.3f}".format(my), "{:+.1%}".format(change),
+                      ci_str, p_str, verdict))
+
+    header = ("row", "old", "new", "change", "{:.0%} CI".format(args.confidence), "p-value", "")
+    widths = [max(len(line[c]) for line in lines + [header]) for c in range(len(header))]
+    for line in [header] + lines:
+        cells = [line[0].ljust(widths[0])] + [line[c].rjust(widths[c]) for c in range(1, 6)]
+        print("  ".join(cells + [line[6]]).rstrip())
+
+    print("\n{} regressions, {} improvements over {:+.0%} (alpha {})".format(
+        n_regressions, n_improvements, args.threshold, args.alpha))
+    if n_underpowered > 0:
+        print("warning: {} rows have too few repetitions to ever reach alpha {}, "
+              "run the benchmarks with more --reps".format(n_underpowered, args.alpha))
+    return 1 if n_regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))